@@ -9,29 +9,87 @@ unsigned get_no_cells(const sudoku *s) {
     return s->size * s->size * s->size * s->size;
 }
 
-sudoku *create_sudoku(unsigned size) {
-    sudoku *newSudoku = malloc(sizeof(sudoku));
-    assert(newSudoku != NULL);
+void *allocate_with(const sudoku_allocator *allocator, size_t size) {
+    return allocator != NULL ? allocator->allocate(size, allocator->context) : malloc(size);
+}
+
+void release_with(const sudoku_allocator *allocator, void *pointer) {
+    if(allocator != NULL) {
+        allocator->release(pointer, allocator->context);
+    }
+    else {
+        free(pointer);
+    }
+}
+
+sudoku *create_sudoku_with(const sudoku_allocator *allocator, unsigned size) {
+    sudoku *newSudoku = allocate_with(allocator, sizeof(sudoku));
+    if(newSudoku == NULL) {
+        return NULL;
+    }
 
     newSudoku->size = size;
-    newSudoku->cells = malloc(sizeof(int) * get_no_cells(newSudoku));
-    assert(newSudoku->cells != NULL);
+    newSudoku->cells = allocate_with(allocator, sizeof(int) * get_no_cells(newSudoku));
+    if(newSudoku->cells == NULL) {
+        release_with(allocator, newSudoku);
+        return NULL;
+    }
 
     return newSudoku;
 }
-sudoku *copy_sudoku(const sudoku* srcSudoku) {
+
+sudoku *copy_sudoku_with(const sudoku_allocator *allocator, const sudoku* srcSudoku) {
     assert(srcSudoku != NULL);
     unsigned size = srcSudoku->size;
-    sudoku * newSudoku = create_sudoku(size);
+    sudoku * newSudoku = create_sudoku_with(allocator, size);
+    if(newSudoku == NULL) {
+        return NULL;
+    }
     memcpy(newSudoku->cells, srcSudoku->cells, sizeof(int) * get_no_cells(newSudoku));
 
     return newSudoku;
 }
 
-void free_sudoku(sudoku* sudoku) {
+void free_sudoku_with(const sudoku_allocator *allocator, sudoku* sudoku) {
     assert(sudoku != NULL);
-    free(sudoku->cells);
-    free(sudoku);
+    release_with(allocator, sudoku->cells);
+    release_with(allocator, sudoku);
+}
+
+static void *arena_allocate(size_t size, void *context) {
+    sudoku_arena *arena = context;
+    size = (size + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT * ARENA_ALIGNMENT;
+    if(size > arena->size - arena->used) {
+        return NULL;
+    }
+    void *block = (unsigned char *) arena->memory + arena->used;
+    arena->used += size;
+    return block;
+}
+
+static void arena_release(void *pointer, void *context) {
+    (void) pointer;
+    (void) context;
+}
+
+sudoku_allocator arena_allocator(sudoku_arena *arena) {
+    return (sudoku_allocator){arena_allocate, arena_release, arena};
+}
+
+sudoku *create_sudoku(unsigned size) {
+    sudoku *newSudoku = create_sudoku_with(NULL, size);
+    assert(newSudoku != NULL);
+    return newSudoku;
+}
+
+sudoku *copy_sudoku(const sudoku* srcSudoku) {
+    sudoku *newSudoku = copy_sudoku_with(NULL, srcSudoku);
+    assert(newSudoku != NULL);
+    return newSudoku;
+}
+
+void free_sudoku(sudoku* sudoku) {
+    free_sudoku_with(NULL, sudoku);
 }
 
 // Getter functions
@@ -6,6 +6,8 @@
 #ifndef SUDOKU_H
 #define SUDOKU_H
 
+#include <stddef.h>
+
 /*
     A structure that holds a suduku
 */
@@ -22,6 +24,16 @@ typedef struct {
     unsigned col;
 } position;
 
+/*
+    Allocation hooks, letting the caller decide where memory comes from. Every function taking an
+    allocator accepts NULL, which means malloc and free.
+*/
+typedef struct {
+    void *(*allocate)(size_t size, void *context); //< returns a block of at least `size` bytes, or NULL
+    void (*release)(void *pointer, void *context); //< frees a block returned by `allocate`
+    void *context; //< passed to both hooks untouched
+} sudoku_allocator;
+
 /**********************
  *  Utility functions *
  **********************/
@@ -63,6 +75,63 @@ sudoku *copy_sudoku(const sudoku* sudoku);
 */
 void free_sudoku(sudoku* sudoku);
 
+/*
+    Allocate a block of memory through the given allocator.
+
+    \param allocator the allocation hooks to use, or NULL for malloc
+    \param size the number of bytes to allocate
+
+    \return the allocated block, or NULL if the allocation failed
+*/
+void *allocate_with(const sudoku_allocator *allocator, size_t size);
+
+/*
+    Free a block of memory returned by allocate_with.
+
+    \param allocator the allocation hooks the block was allocated with, or NULL for free
+    \param pointer the block to be freed
+*/
+void release_with(const sudoku_allocator *allocator, void *pointer);
+
+/*
+    Same as create_sudoku, allocating through the given allocator, but returning NULL if the
+    allocator fails (create_sudoku treats running out of memory as fatal).
+*/
+sudoku *create_sudoku_with(const sudoku_allocator *allocator, unsigned size);
+
+/*
+    Same as copy_sudoku, allocating through the given allocator, but returning NULL if the
+    allocator fails.
+*/
+sudoku *copy_sudoku_with(const sudoku_allocator *allocator, const sudoku* sudoku);
+
+/*
+    Same as free_sudoku, for sudokus created through the given allocator.
+*/
+void free_sudoku_with(const sudoku_allocator *allocator, sudoku* sudoku);
+
+/*
+    A block of memory owned by the caller, handed out front to back by arena_allocator.
+*/
+typedef struct {
+    void *memory; //< the start of the block
+    size_t size; //< the size of the block in bytes
+    size_t used; //< the number of bytes handed out so far
+} sudoku_arena;
+
+// Every block handed out by an arena is aligned to this many bytes, and takes up a multiple of it.
+#define ARENA_ALIGNMENT 16
+
+/*
+    Makes allocation hooks handing out the memory of an arena. Releasing a block does nothing:
+    the whole arena is reused by setting `used` back to 0.
+
+    \param arena the arena to allocate from, whose memory must be aligned to ARENA_ALIGNMENT
+
+    \return allocation hooks whose allocations fail once the arena is used up
+*/
+sudoku_allocator arena_allocator(sudoku_arena *arena);
+
 /*********************
  *  Getter functions *
  *********************/
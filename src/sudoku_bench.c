@@ -0,0 +1,314 @@
+#define _POSIX_C_SOURCE 200809L
+
+/*
+    The dancing links primitives (cover_column, get_smallest_column, ...) are static, so the
+    engine is compiled into the benchmarks, without solve_sudoku, to measure them in isolation.
+*/
+#define SUDOKU_ENGINE_ONLY
+#include "sudoku_solve_advanced.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Every benchmark first runs unmeasured for this many seconds, to warm up the caches, the branch
+// predictors and the clock speed of the processor.
+static const double WARMUP_SECONDS = 0.1;
+
+// A sample repeats the operation for about this many seconds, far above the clock's resolution.
+static const double SAMPLE_SECONDS = 0.01;
+
+// The number of samples of every benchmark. The median is reported, with the interquartile range
+// as its spread, both of which a few samples disturbed by the rest of the system don't move.
+#define NO_SAMPLES 21
+
+// Keeps the compiler from dropping the results of the operations measured.
+static volatile long sink;
+
+/*
+    An operation to measure.
+*/
+typedef struct {
+    char name[48];
+    void (*run)(void *context, unsigned long noOps); //< runs the operation noOps times
+    void *context; //< what the operation works on
+    size_t noBytes; //< the number of bytes the operation goes through, or 0 to not report a throughput
+} benchmark;
+
+static double seconds_since(const struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static double time_run(const benchmark *bench, unsigned long noOps) {
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    bench->run(bench->context, noOps);
+    return seconds_since(&start);
+}
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *) a, y = *(const double *) b;
+    return x < y ? -1 : x > y;
+}
+
+/*
+    Measures a benchmark and writes its line: the median time of an operation, the spread of the
+    samples and the throughput.
+
+    \param bench the benchmark to measure
+*/
+static void measure(const benchmark *bench) {
+    // Warm up, doubling the number of operations of a run until a run takes a sample's time.
+    unsigned long noOps = 1;
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    double runSeconds = time_run(bench, noOps);
+    while(seconds_since(&start) < WARMUP_SECONDS || runSeconds < SAMPLE_SECONDS) {
+        if(runSeconds < SAMPLE_SECONDS) {
+            noOps *= 2;
+        }
+        runSeconds = time_run(bench, noOps);
+    }
+
+    double nsPerOp[NO_SAMPLES];
+    for(unsigned i = 0; i < NO_SAMPLES; ++i) {
+        nsPerOp[i] = time_run(bench, noOps) * 1e9 / noOps;
+    }
+    qsort(nsPerOp, NO_SAMPLES, sizeof(double), compare_doubles);
+
+    const double median = nsPerOp[NO_SAMPLES / 2];
+    const double spread = nsPerOp[3 * NO_SAMPLES / 4] - nsPerOp[NO_SAMPLES / 4];
+    printf("%-40s %12.1f ns/op  +-%5.1f%%", bench->name, median, 100 * spread / 2 / median);
+    if(bench->noBytes > 0) {
+        printf("  %10.1f MB/s", bench->noBytes / median * 1e3);
+    }
+    printf("\n");
+    fflush(stdout);
+}
+
+/*
+    Creates a complete, valid sudoku.
+*/
+static sudoku *complete_sudoku(unsigned size) {
+    const unsigned sectionSize = size * size;
+    sudoku *s = create_sudoku(size);
+    for(unsigned row = 0; row < sectionSize; ++row) {
+        for(unsigned col = 0; col < sectionSize; ++col) {
+            set_cell(s, row, col, (row * size + row / size + col) % sectionSize + 1);
+        }
+    }
+    return s;
+}
+
+typedef struct {
+    unsigned size;
+    int *values;
+} list_context;
+
+static void run_check_list(void *context, unsigned long noOps) {
+    const list_context *list = context;
+    long total = 0;
+    for(unsigned long i = 0; i < noOps; ++i) {
+        total += check_list(list->values, list->size);
+    }
+    sink = total;
+}
+
+typedef struct {
+    sudoku *s;
+    int *buffer;
+} section_context;
+
+static void run_get_row(void *context, unsigned long noOps) {
+    section_context *section = context;
+    const unsigned sectionSize = section->s->size * section->s->size;
+    long total = 0;
+    for(unsigned long i = 0; i < noOps; ++i) {
+        get_row(section->s, i % sectionSize, section->buffer);
+        total += section->buffer[0];
+    }
+    sink = total;
+}
+
+static void run_get_col(void *context, unsigned long noOps) {
+    section_context *section = context;
+    const unsigned sectionSize = section->s->size * section->s->size;
+    long total = 0;
+    for(unsigned long i = 0; i < noOps; ++i) {
+        get_col(section->s, i % sectionSize, section->buffer);
+        total += section->buffer[0];
+    }
+    sink = total;
+}
+
+static void run_get_square(void *context, unsigned long noOps) {
+    section_context *section = context;
+    const unsigned size = section->s->size;
+    long total = 0;
+    for(unsigned long i = 0; i < noOps; ++i) {
+        get_square(section->s, (i / size) % size, i % size, section->buffer);
+        total += section->buffer[0];
+    }
+    sink = total;
+}
+
+static void run_check_sudoku(void *context, unsigned long noOps) {
+    const sudoku *s = context;
+    long total = 0;
+    for(unsigned long i = 0; i < noOps; ++i) {
+        total += check_sudoku(s);
+    }
+    sink = total;
+}
+
+static void run_cover_uncover(void *context, unsigned long noOps) {
+    constraint_table *table = context;
+    long total = 0;
+    for(unsigned long i = 0; i < noOps; ++i) {
+        node_index column = 1 + i % table->noColumns;
+        cover_column(table, column);
+        uncover_column(table, column);
+        total += table->sizes[column];
+    }
+    sink = total;
+}
+
+static void run_get_smallest_column(void *context, unsigned long noOps) {
+    const constraint_table *table = context;
+    long total = 0;
+    for(unsigned long i = 0; i < noOps; ++i) {
+        total += get_smallest_column(table);
+    }
+    sink = total;
+}
+
+typedef struct {
+    sudoku *s;
+    char *text; //< the sudoku as read_sudoku reads it
+    size_t length;
+} text_context;
+
+static void run_read_sudoku(void *context, unsigned long noOps) {
+    const text_context *text = context;
+    FILE *input = fmemopen(text->text, text->length, "r");
+    assert(input != NULL);
+    long total = 0;
+    for(unsigned long i = 0; i < noOps; ++i) {
+        rewind(input);
+        sudoku *s = read_sudoku(input);
+        total += s->cells[0];
+        free_sudoku(s);
+    }
+    fclose(input);
+    sink = total;
+}
+
+static void run_write_sudoku(void *context, unsigned long noOps) {
+    const text_context *text = context;
+    char *buffer = malloc(text->length + 1);
+    assert(buffer != NULL);
+    FILE *output = fmemopen(buffer, text->length + 1, "w");
+    assert(output != NULL);
+    for(unsigned long i = 0; i < noOps; ++i) {
+        rewind(output);
+        write_sudoku(output, text->s);
+        fflush(output);
+    }
+    fclose(output);
+    sink = buffer[0];
+    free(buffer);
+}
+
+/*
+    Usage: sudoku_bench [FILTER]
+
+    Measures the primitives the checkers and the solvers are built from, one by one: checking a
+    list, copying rows, columns and boxes out of a sudoku, checking a complete 81x81 sudoku,
+    covering and uncovering a column of a dancing links table, finding its smallest column, and
+    reading and writing a sudoku. With FILTER, only the benchmarks whose name contains it are run.
+
+    The times depend on how the program was compiled; build both sides of a comparison the same
+    way (e.g. make CFLAGS="-c -std=c99 -O2" sudoku_bench).
+*/
+int main(int argc, char **argv) {
+    const char *filter = argc > 1 ? argv[1] : "";
+
+    static const unsigned LIST_SIZES[] = {2, 3, 4, 5, 7, 9};
+    static const unsigned TABLE_SIZES[] = {3, 5};
+    const unsigned noLists = sizeof(LIST_SIZES) / sizeof(LIST_SIZES[0]);
+    const unsigned noTables = sizeof(TABLE_SIZES) / sizeof(TABLE_SIZES[0]);
+
+    benchmark benchmarks[32];
+    unsigned noBenchmarks = 0;
+
+    list_context lists[noLists];
+    for(unsigned i = 0; i < noLists; ++i) {
+        const unsigned sectionSize = LIST_SIZES[i] * LIST_SIZES[i];
+        lists[i].size = LIST_SIZES[i];
+        lists[i].values = malloc(sizeof(int) * sectionSize);
+        assert(lists[i].values != NULL);
+        for(unsigned value = 0; value < sectionSize; ++value) {
+            lists[i].values[value] = sectionSize - value;
+        }
+        benchmark *bench = &benchmarks[noBenchmarks++];
+        *bench = (benchmark){"", run_check_list, &lists[i], sizeof(int) * sectionSize};
+        sprintf(bench->name, "check_list %ux%u", sectionSize, sectionSize);
+    }
+
+    // An 81x81 sudoku, the largest the checkers are usually given.
+    const unsigned bigSize = 9;
+    const unsigned bigSection = bigSize * bigSize;
+    sudoku *big = complete_sudoku(bigSize);
+    section_context section = {big, malloc(sizeof(int) * bigSection)};
+    assert(section.buffer != NULL);
+    benchmarks[noBenchmarks++] = (benchmark){"get_row 81x81", run_get_row, &section, sizeof(int) * bigSection};
+    benchmarks[noBenchmarks++] = (benchmark){"get_col 81x81", run_get_col, &section, sizeof(int) * bigSection};
+    benchmarks[noBenchmarks++] = (benchmark){"get_square 81x81", run_get_square, &section, sizeof(int) * bigSection};
+    benchmarks[noBenchmarks++] = (benchmark){"check_sudoku 81x81 complete", run_check_sudoku, big,
+                                             sizeof(int) * get_no_cells(big)};
+
+    constraint_table *tables[noTables];
+    for(unsigned i = 0; i < noTables; ++i) {
+        const unsigned sectionSize = TABLE_SIZES[i] * TABLE_SIZES[i];
+        sudoku *empty = create_sudoku(TABLE_SIZES[i]);
+        tables[i] = generate_table(empty, NULL);
+        free_sudoku(empty);
+
+        benchmark *bench = &benchmarks[noBenchmarks++];
+        *bench = (benchmark){"", run_cover_uncover, tables[i], 0};
+        sprintf(bench->name, "cover+uncover_column %ux%u empty", sectionSize, sectionSize);
+        // Every column of an empty sudoku has as many rows, so the whole header list is scanned.
+        bench = &benchmarks[noBenchmarks++];
+        *bench = (benchmark){"", run_get_smallest_column, tables[i], 0};
+        sprintf(bench->name, "get_smallest_column %ux%u empty", sectionSize, sectionSize);
+    }
+
+    text_context text = {big, NULL, 0};
+    FILE *output = open_memstream(&text.text, &text.length);
+    assert(output != NULL);
+    fprintf(output, "%u\n", bigSize);
+    write_sudoku(output, big);
+    fclose(output);
+    benchmarks[noBenchmarks++] = (benchmark){"read_sudoku 81x81", run_read_sudoku, &text, text.length};
+    benchmarks[noBenchmarks++] = (benchmark){"write_sudoku 81x81", run_write_sudoku, &text, text.length};
+
+    for(unsigned i = 0; i < noBenchmarks; ++i) {
+        if(strstr(benchmarks[i].name, filter) != NULL) {
+            measure(&benchmarks[i]);
+        }
+    }
+
+    for(unsigned i = 0; i < noLists; ++i) {
+        free(lists[i].values);
+    }
+    for(unsigned i = 0; i < noTables; ++i) {
+        free_constraint_table(tables[i]);
+    }
+    free(section.buffer);
+    free(text.text);
+    free_sudoku(big);
+    return 0;
+}
@@ -0,0 +1,705 @@
+#include "sudoku_canon.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+
+/*
+    A stored result. Puzzle and solution are kept in canonical coordinates, one byte per cell.
+*/
+typedef struct {
+    unsigned size; //< the size of the sudoku, or 0 if the entry is unused
+    solve_status status; //< the result of solving the sudoku
+    uint64_t hash; //< the hash of `cells`
+    unsigned char *cells; //< the canonical form of the solved sudoku
+    unsigned char *solution; //< the canonical form of the solution, or NULL if there was none
+    int next; //< the next entry in the same bucket, or -1
+} cache_entry;
+
+struct solve_cache {
+    unsigned capacity; //< the number of entries
+    unsigned noBuckets; //< the number of hash buckets
+    int *buckets; //< the first entry of every bucket, or -1
+    cache_entry *entries; //< all the entries, used as a ring buffer for eviction
+    unsigned oldest; //< the entry to be replaced next
+};
+
+static const char CACHE_MAGIC[4] = {'S', 'D', 'K', 'R'};
+
+/*
+    Lines (or whole bands) that the clue counts can't tell apart, and so may come in any order.
+*/
+typedef struct {
+    unsigned start; //< the position of the first tied line in the ordering
+    unsigned length; //< the number of tied blocks
+    unsigned blockSize; //< the number of lines in every block: 1 for rows, the size for bands
+    unsigned *permutation; //< the order the blocks are currently taken in
+} tie_group;
+
+/*
+    An ordering of the rows (or columns) of a sudoku, with the ties that can be permuted.
+*/
+typedef struct {
+    unsigned order[CANON_MAX_SIZE * CANON_MAX_SIZE]; //< the original index of every line, ties in input order
+    unsigned noGroups; //< the number of groups of tied rows and bands
+    tie_group groups[CANON_MAX_SIZE * CANON_MAX_SIZE]; //< the row groups first, then the band groups
+    unsigned permutations[CANON_MAX_SIZE * CANON_MAX_SIZE * 2]; //< the storage of the group permutations
+    unsigned long noOrderings; //< the number of orderings the ties allow (saturates past CANON_MAX_ORDERINGS)
+} line_ordering;
+
+/*******************
+ *  Canonical form *
+ *******************/
+
+/*
+    Retrieves a cell of a sudoku, as seen after an optional transposition.
+
+    \param s the sudoku to look in
+    \param transposed if rows and columns are swapped
+    \param row the row of the cell in the transposed view
+    \param col the column of the cell in the transposed view
+
+    \return the value of that cell
+*/
+static int oriented_cell(const sudoku *s, bool transposed, unsigned row, unsigned col) {
+    return transposed ? get_cell(s, col, row) : get_cell(s, row, col);
+}
+
+/*
+    Compares two rows of keys lexicographically.
+
+    \return a negative value, zero or a positive value if `a` is smaller, equal or greater than `b`
+*/
+static int compare_keys(const unsigned *a, const unsigned *b, unsigned length) {
+    for(unsigned i = 0; i < length; ++i) {
+        if(a[i] != b[i]) {
+            return a[i] < b[i] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+/*
+    Orders the rows of a (possibly transposed) sudoku by how many clues they hold, keeping every
+    row within its band.
+
+    A row's key is its clue count, followed by the sum of the clue counts of the columns of its
+    clues. Both are unchanged by every symmetry, so equivalent sudokus get the same keys. Rows are
+    sorted by decreasing key within their band, then bands are sorted by their sorted keys. Ties
+    keep the original order, and are recorded so that every order of them can be tried.
+
+    \param s the sudoku to order
+    \param transposed if the columns should be ordered instead
+    \param ordering filled in with the original index of every row, in canonical order, and the ties
+*/
+static void canonical_line_order(const sudoku *s, bool transposed, line_ordering *ordering) {
+    const unsigned size = s->size;
+    const unsigned sectionSize = size * size;
+
+    unsigned rowCount[sectionSize];
+    unsigned colCount[sectionSize];
+    for(unsigned i = 0; i < sectionSize; ++i) {
+        rowCount[i] = colCount[i] = 0;
+    }
+    for(unsigned row = 0; row < sectionSize; ++row) {
+        for(unsigned col = 0; col < sectionSize; ++col) {
+            if(oriented_cell(s, transposed, row, col) != 0) {
+                rowCount[row]++;
+                colCount[col]++;
+            }
+        }
+    }
+
+    unsigned key[sectionSize];
+    for(unsigned row = 0; row < sectionSize; ++row) {
+        unsigned crossCount = 0;
+        for(unsigned col = 0; col < sectionSize; ++col) {
+            if(oriented_cell(s, transposed, row, col) != 0) {
+                crossCount += colCount[col];
+            }
+        }
+        key[row] = rowCount[row] * (sectionSize * sectionSize + 1) + crossCount;
+    }
+
+    // Sort the rows of every band by decreasing key (insertion sort keeps ties in order).
+    unsigned inBand[size][size];
+    unsigned bandKeys[size][size];
+    for(unsigned band = 0; band < size; ++band) {
+        for(unsigned i = 0; i < size; ++i) {
+            unsigned row = band * size + i;
+            unsigned j = i;
+            while(j > 0 && key[inBand[band][j - 1]] < key[row]) {
+                inBand[band][j] = inBand[band][j - 1];
+                j--;
+            }
+            inBand[band][j] = row;
+        }
+        for(unsigned i = 0; i < size; ++i) {
+            bandKeys[band][i] = key[inBand[band][i]];
+        }
+    }
+
+    // Sort the bands by decreasing sorted keys.
+    unsigned bands[size];
+    for(unsigned band = 0; band < size; ++band) {
+        unsigned j = band;
+        while(j > 0 && compare_keys(bandKeys[bands[j - 1]], bandKeys[band], size) < 0) {
+            bands[j] = bands[j - 1];
+            j--;
+        }
+        bands[j] = band;
+    }
+
+    for(unsigned b = 0; b < size; ++b) {
+        for(unsigned i = 0; i < size; ++i) {
+            ordering->order[b * size + i] = inBand[bands[b]][i];
+        }
+    }
+
+    // Record the runs of equal keys, rows within their band and then bands.
+    ordering->noGroups = 0;
+    ordering->noOrderings = 1;
+    unsigned *nextPermutation = ordering->permutations;
+    for(unsigned b = 0; b <= size; ++b) {
+        const bool bandRun = b == size;
+        for(unsigned start = 0; start < size;) {
+            unsigned end = start + 1;
+            while(end < size && (bandRun ? compare_keys(bandKeys[bands[start]], bandKeys[bands[end]], size) == 0
+                                 : key[inBand[bands[b]][start]] == key[inBand[bands[b]][end]])) {
+                end++;
+            }
+            if(end - start > 1) {
+                tie_group *group = &ordering->groups[ordering->noGroups++];
+                group->start = bandRun ? start * size : b * size + start;
+                group->length = end - start;
+                group->blockSize = bandRun ? size : 1;
+                group->permutation = nextPermutation;
+                for(unsigned i = 0; i < group->length; ++i) {
+                    group->permutation[i] = i;
+                    // Saturates, only telling whether there are too many orderings to try.
+                    if(ordering->noOrderings <= CANON_MAX_ORDERINGS) {
+                        ordering->noOrderings *= i + 1;
+                    }
+                }
+                nextPermutation += group->length;
+            }
+            start = end;
+        }
+    }
+}
+
+/*
+    Writes out the ordering of lines that the current permutations of the ties give.
+
+    \param ordering the ordering and its ties
+    \param sectionSize the number of lines
+    \param order filled in with the original index of every line
+*/
+static void current_line_order(const line_ordering *ordering, unsigned sectionSize, unsigned *order) {
+    memcpy(order, ordering->order, sizeof(unsigned) * sectionSize);
+    // Rows are permuted within their band first, so moving the bands takes them along.
+    for(unsigned g = 0; g < ordering->noGroups; ++g) {
+        const tie_group *group = &ordering->groups[g];
+        unsigned moved[CANON_MAX_SIZE * CANON_MAX_SIZE];
+        memcpy(moved, order + group->start, sizeof(unsigned) * group->length * group->blockSize);
+        for(unsigned i = 0; i < group->length; ++i) {
+            memcpy(order + group->start + i * group->blockSize, moved + group->permutation[i] * group->blockSize,
+                   sizeof(unsigned) * group->blockSize);
+        }
+    }
+}
+
+/*
+    Steps a permutation to the next one in lexicographic order.
+
+    \return false if it was the last, in which case it goes back to the first
+*/
+static bool next_permutation(unsigned *permutation, unsigned length) {
+    unsigned i = length - 1;
+    while(i > 0 && permutation[i - 1] > permutation[i]) {
+        i--;
+    }
+    if(i > 0) {
+        unsigned j = length - 1;
+        while(permutation[j] < permutation[i - 1]) {
+            j--;
+        }
+        unsigned swapped = permutation[i - 1];
+        permutation[i - 1] = permutation[j];
+        permutation[j] = swapped;
+    }
+    // Reverse the tail, which is descending.
+    for(unsigned lo = i, hi = length - 1; lo < hi; ++lo, --hi) {
+        unsigned swapped = permutation[lo];
+        permutation[lo] = permutation[hi];
+        permutation[hi] = swapped;
+    }
+    return i > 0;
+}
+
+/*
+    Steps to the next order of the ties, counting through the permutations of every group.
+
+    \return false once every order was gone through
+*/
+static bool next_line_order(line_ordering *ordering) {
+    for(unsigned g = ordering->noGroups; g > 0; --g) {
+        if(next_permutation(ordering->groups[g - 1].permutation, ordering->groups[g - 1].length)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+    Applies the row, column and transposition part of a transformation and then labels the digits
+    in the order they first appear, completing the transformation.
+
+    \param s the sudoku to transform
+    \param transform the transformation, whose digits are filled in
+    \param dest the sudoku to write the transformed cells to
+*/
+static void apply_and_relabel(const sudoku *s, sudoku_transform *transform, sudoku *dest) {
+    const unsigned sectionSize = s->size * s->size;
+
+    for(unsigned digit = 0; digit <= sectionSize; ++digit) {
+        transform->digits[digit] = 0;
+    }
+
+    int nextLabel = 1;
+    for(unsigned row = 0; row < sectionSize; ++row) {
+        for(unsigned col = 0; col < sectionSize; ++col) {
+            int value = oriented_cell(s, transform->transposed, transform->rows[row], transform->cols[col]);
+            if(value != 0 && transform->digits[value] == 0) {
+                transform->digits[value] = nextLabel++;
+            }
+            set_cell(dest, row, col, value == 0 ? 0 : transform->digits[value]);
+        }
+    }
+
+    // Digits that don't appear still need a label, so the relabeling can be undone.
+    for(unsigned digit = 1; digit <= sectionSize; ++digit) {
+        if(transform->digits[digit] == 0) {
+            transform->digits[digit] = nextLabel++;
+        }
+    }
+}
+
+/*
+    Compares two sudokus of the same size cell by cell.
+
+    \return a negative value, zero or a positive value if `a` is smaller, equal or greater than `b`
+*/
+static int compare_sudokus(const sudoku *a, const sudoku *b) {
+    const unsigned noCells = get_no_cells(a);
+    for(unsigned i = 0; i < noCells; ++i) {
+        if(a->cells[i] != b->cells[i]) {
+            return a->cells[i] < b->cells[i] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+sudoku *canonicalize_sudoku(const sudoku *s, sudoku_transform *transform) {
+    assert(s != NULL);
+    assert(s->size <= CANON_MAX_SIZE);
+    const unsigned sectionSize = s->size * s->size;
+
+    sudoku *best = NULL;
+    sudoku *form = create_sudoku(s->size);
+    sudoku_transform candidate;
+    candidate.size = s->size;
+
+    // The clue counts of the rows and columns swap places when transposing, so both orientations
+    // have as many ties, and either both are tried in full or neither is.
+    line_ordering rows;
+    line_ordering cols;
+    for(int transposed = 0; transposed <= 1; ++transposed) {
+        candidate.transposed = transposed;
+        canonical_line_order(s, transposed, &rows);
+        canonical_line_order(s, !transposed, &cols);
+        if(rows.noOrderings > CANON_MAX_ORDERINGS || cols.noOrderings > CANON_MAX_ORDERINGS
+           || rows.noOrderings * cols.noOrderings > CANON_MAX_ORDERINGS) {
+            rows.noGroups = cols.noGroups = 0;
+        }
+
+        // The smallest form over every order of the ties.
+        do {
+            current_line_order(&rows, sectionSize, candidate.rows);
+            do {
+                current_line_order(&cols, sectionSize, candidate.cols);
+                apply_and_relabel(s, &candidate, form);
+
+                if(best == NULL || compare_sudokus(form, best) < 0) {
+                    sudoku *replaced = best;
+                    best = form;
+                    form = replaced != NULL ? replaced : create_sudoku(s->size);
+                    *transform = candidate;
+                }
+            } while(next_line_order(&cols));
+        } while(next_line_order(&rows));
+    }
+
+    free_sudoku(form);
+    return best;
+}
+
+sudoku *undo_transform(const sudoku *canonical, const sudoku_transform *transform) {
+    assert(canonical->size == transform->size);
+    const unsigned sectionSize = canonical->size * canonical->size;
+
+    int original[sectionSize + 1];
+    original[0] = 0;
+    for(unsigned digit = 1; digit <= sectionSize; ++digit) {
+        original[transform->digits[digit]] = digit;
+    }
+
+    sudoku *s = create_sudoku(canonical->size);
+    for(unsigned row = 0; row < sectionSize; ++row) {
+        for(unsigned col = 0; col < sectionSize; ++col) {
+            int value = original[get_cell(canonical, row, col)];
+            if(transform->transposed) {
+                set_cell(s, transform->cols[col], transform->rows[row], value);
+            }
+            else {
+                set_cell(s, transform->rows[row], transform->cols[col], value);
+            }
+        }
+    }
+    return s;
+}
+
+/*****************
+ *  Result cache *
+ *****************/
+
+/*
+    Hashes the cells of a sudoku (FNV-1a).
+
+    \param size the size of the sudoku
+    \param cells the cells, one byte each
+
+    \return the hash
+*/
+static uint64_t hash_cells(unsigned size, const unsigned char *cells) {
+    uint64_t hash = 14695981039346656037ULL ^ size;
+    const unsigned noCells = size * size * size * size;
+    for(unsigned i = 0; i < noCells; ++i) {
+        hash = (hash ^ cells[i]) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+/*
+    Packs the cells of a sudoku one byte per cell.
+
+    \param s the sudoku to pack
+    \param dest buffer with room for all the cells
+*/
+static void pack_cells(const sudoku *s, unsigned char *dest) {
+    const unsigned noCells = get_no_cells(s);
+    for(unsigned i = 0; i < noCells; ++i) {
+        dest[i] = (unsigned char) s->cells[i];
+    }
+}
+
+solve_cache *create_solve_cache(unsigned capacity) {
+    assert(capacity > 0);
+
+    solve_cache *cache = malloc(sizeof(solve_cache));
+    assert(cache != NULL);
+
+    cache->capacity = capacity;
+    cache->noBuckets = capacity * 2;
+    cache->oldest = 0;
+
+    cache->buckets = malloc(sizeof(int) * cache->noBuckets);
+    assert(cache->buckets != NULL);
+    for(unsigned i = 0; i < cache->noBuckets; ++i) {
+        cache->buckets[i] = -1;
+    }
+
+    cache->entries = calloc(capacity, sizeof(cache_entry));
+    assert(cache->entries != NULL);
+
+    return cache;
+}
+
+/*
+    Frees the cells held by an entry and marks it as unused.
+
+    \param entry the entry to clear
+*/
+static void clear_entry(cache_entry *entry) {
+    free(entry->cells);
+    free(entry->solution);
+    entry->cells = NULL;
+    entry->solution = NULL;
+    entry->size = 0;
+}
+
+void free_solve_cache(solve_cache *cache) {
+    assert(cache != NULL);
+    for(unsigned i = 0; i < cache->capacity; ++i) {
+        clear_entry(&cache->entries[i]);
+    }
+    free(cache->entries);
+    free(cache->buckets);
+    free(cache);
+}
+
+/*
+    Looks up the entry for a canonical form.
+
+    \param cache the cache to look in
+    \param size the size of the sudoku
+    \param cells its canonical cells, one byte each
+    \param hash the hash of the cells
+
+    \return the entry, or NULL if the cache doesn't hold it
+*/
+static cache_entry *find_entry(solve_cache *cache, unsigned size, const unsigned char *cells, uint64_t hash) {
+    const unsigned noCells = size * size * size * size;
+    int index = cache->buckets[hash % cache->noBuckets];
+    while(index != -1) {
+        cache_entry *entry = &cache->entries[index];
+        if(entry->hash == hash && entry->size == size && memcmp(entry->cells, cells, noCells) == 0) {
+            return entry;
+        }
+        index = entry->next;
+    }
+    return NULL;
+}
+
+/*
+    Stores a result in the cache, evicting the oldest one if it is full. The cache takes ownership
+    of both buffers.
+
+    \param cache the cache to store in
+    \param size the size of the sudoku
+    \param cells its canonical cells, one byte each
+    \param status the result of solving it
+    \param solution the canonical solution, one byte per cell, or NULL
+*/
+static void insert_entry(solve_cache *cache, unsigned size, unsigned char *cells,
+                         solve_status status, unsigned char *solution) {
+    const int index = cache->oldest;
+    cache_entry *entry = &cache->entries[index];
+    cache->oldest = (cache->oldest + 1) % cache->capacity;
+
+    if(entry->size != 0) {
+        // Unlink the evicted entry from its bucket.
+        int *link = &cache->buckets[entry->hash % cache->noBuckets];
+        while(*link != index) {
+            link = &cache->entries[*link].next;
+        }
+        *link = entry->next;
+        clear_entry(entry);
+    }
+
+    entry->size = size;
+    entry->status = status;
+    entry->hash = hash_cells(size, cells);
+    entry->cells = cells;
+    entry->solution = solution;
+
+    int *bucket = &cache->buckets[entry->hash % cache->noBuckets];
+    entry->next = *bucket;
+    *bucket = index;
+}
+
+solve_result cached_solve_sudoku(solve_cache *cache, const sudoku *input) {
+    return cached_solve_sudoku_into(cache, input, NULL, 0);
+}
+
+solve_result cached_solve_sudoku_into(solve_cache *cache, const sudoku *input, void *scratch, size_t scratchSize) {
+    sudoku_transform transform;
+    sudoku *canonical = canonicalize_sudoku(input, &transform);
+    const unsigned noCells = get_no_cells(canonical);
+
+    unsigned char *cells = malloc(noCells);
+    assert(cells != NULL);
+    pack_cells(canonical, cells);
+
+    solve_result result;
+    cache_entry *entry = find_entry(cache, canonical->size, cells, hash_cells(canonical->size, cells));
+
+    if(entry != NULL) {
+        free(cells);
+        result.status = entry->status;
+        result.solution = NULL;
+        if(entry->solution != NULL) {
+            for(unsigned i = 0; i < noCells; ++i) {
+                canonical->cells[i] = entry->solution[i];
+            }
+            result.solution = undo_transform(canonical, &transform);
+        }
+    }
+    else {
+        solve_result canonicalResult;
+        if(scratch != NULL) {
+            canonicalResult.solution = create_sudoku(canonical->size);
+            canonicalResult.status = solve_sudoku_into(canonical, canonicalResult.solution, scratch, scratchSize, 0);
+            if(canonicalResult.status != SR_SOLVED && canonicalResult.status != SR_MULTIPLE) {
+                free_sudoku(canonicalResult.solution);
+                canonicalResult.solution = NULL;
+            }
+        }
+        else {
+            canonicalResult = solve_sudoku(canonical);
+        }
+        result.status = canonicalResult.status;
+        result.solution = NULL;
+
+        unsigned char *solution = NULL;
+        if(canonicalResult.solution != NULL) {
+            solution = malloc(noCells);
+            assert(solution != NULL);
+            pack_cells(canonicalResult.solution, solution);
+            result.solution = undo_transform(canonicalResult.solution, &transform);
+            free_sudoku(canonicalResult.solution);
+        }
+
+        if(canonicalResult.status != SR_ABORTED) {
+            insert_entry(cache, canonical->size, cells, canonicalResult.status, solution);
+        }
+        else {
+            free(cells);
+            free(solution);
+        }
+    }
+
+    free_sudoku(canonical);
+    return result;
+}
+
+/*
+    File layout: the magic "SDKR", then for every entry its size, status and a flag telling if a
+    solution follows, then its cells and its solution, one byte per cell.
+*/
+int save_solve_cache(const solve_cache *cache, const char *path) {
+    FILE *file = fopen(path, "wb");
+    if(file == NULL) {
+        return -1;
+    }
+
+    int status = fwrite(CACHE_MAGIC, 1, 4, file) == 4 ? 0 : -1;
+
+    // Oldest entries first, so loading the file evicts in the same order.
+    for(unsigned i = 0; i < cache->capacity && status == 0; ++i) {
+        const cache_entry *entry = &cache->entries[(cache->oldest + i) % cache->capacity];
+        if(entry->size == 0) {
+            continue;
+        }
+
+        const unsigned noCells = entry->size * entry->size * entry->size * entry->size;
+        unsigned char header[3] = {entry->size, entry->status, entry->solution != NULL};
+        if(fwrite(header, 1, 3, file) != 3 || fwrite(entry->cells, 1, noCells, file) != noCells
+                || (entry->solution != NULL && fwrite(entry->solution, 1, noCells, file) != noCells)) {
+            status = -1;
+        }
+    }
+
+    if(fclose(file) != 0) {
+        status = -1;
+    }
+    return status;
+}
+
+/*
+    Checks that the cells of a stored sudoku all hold values of the sudoku.
+
+    \param size the size of the sudoku
+    \param cells the cells, one byte each
+    \param complete if empty cells are out of range too, as in a solution
+
+    \return true if every cell is in range
+*/
+static bool cells_in_range(unsigned size, const unsigned char *cells, bool complete) {
+    const unsigned noCells = size * size * size * size;
+    for(unsigned i = 0; i < noCells; ++i) {
+        if(cells[i] > size * size || (complete && cells[i] == 0)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+    A result read from a cache file, held until the whole file is known to be sound.
+*/
+typedef struct {
+    unsigned size;
+    solve_status status;
+    unsigned char *cells;
+    unsigned char *solution;
+} loaded_entry;
+
+int load_solve_cache(solve_cache *cache, const char *path) {
+    FILE *file = fopen(path, "rb");
+    if(file == NULL) {
+        return -1;
+    }
+
+    char magic[4];
+    if(fread(magic, 1, 4, file) != 4 || memcmp(magic, CACHE_MAGIC, 4) != 0) {
+        fclose(file);
+        return -1;
+    }
+
+    int status = 0;
+    unsigned noLoaded = 0;
+    unsigned capacity = 0;
+    loaded_entry *loaded = NULL;
+    unsigned char header[3];
+    while(fread(header, 1, 3, file) == 3) {
+        const unsigned size = header[0];
+        // A solved sudoku has its solution stored, and an unsolvable one can't.
+        if(size < 1 || size > CANON_MAX_SIZE || header[1] > SR_UNSOLVABLE || header[2] > 1
+           || (header[1] == SR_SOLVED && !header[2]) || (header[1] == SR_UNSOLVABLE && header[2])) {
+            status = -1;
+            break;
+        }
+
+        const unsigned noCells = size * size * size * size;
+        unsigned char *cells = malloc(noCells);
+        assert(cells != NULL);
+        unsigned char *solution = NULL;
+        if(header[2]) {
+            solution = malloc(noCells);
+            assert(solution != NULL);
+        }
+
+        if(fread(cells, 1, noCells, file) != noCells || !cells_in_range(size, cells, false)
+                || (solution != NULL && (fread(solution, 1, noCells, file) != noCells
+                                         || !cells_in_range(size, solution, true)))) {
+            free(cells);
+            free(solution);
+            status = -1;
+            break;
+        }
+
+        if(noLoaded == capacity) {
+            capacity = capacity > 0 ? 2 * capacity : 64;
+            loaded = realloc(loaded, sizeof(loaded_entry) * capacity);
+            assert(loaded != NULL);
+        }
+        loaded[noLoaded++] = (loaded_entry){size, (solve_status) header[1], cells, solution};
+    }
+    fclose(file);
+
+    // A damaged file is rejected as a whole, so none of its results are trusted.
+    for(unsigned i = 0; i < noLoaded; ++i) {
+        const loaded_entry *entry = &loaded[i];
+        if(status == 0 && find_entry(cache, entry->size, entry->cells, hash_cells(entry->size, entry->cells)) == NULL) {
+            insert_entry(cache, entry->size, entry->cells, entry->status, entry->solution);
+        }
+        else {
+            free(entry->cells);
+            free(entry->solution);
+        }
+    }
+    free(loaded);
+    return status;
+}
@@ -0,0 +1,145 @@
+/*
+    \file sudoku_canon.h
+    \brief Canonical forms of sudokus and a cache of solve results keyed by them
+
+    Two sudokus are equivalent if one can be turned into the other by relabeling digits,
+    transposing, permuting bands (stacks) and permuting rows (columns) within their band (stack).
+    Equivalent sudokus have the same number of solutions, and the solutions map onto each other
+    through the same transformation, so a result only needs to be searched for once per class.
+*/
+
+#ifndef SUDOKU_CANON_H
+#define SUDOKU_CANON_H
+
+#include "sudoku.h"
+#include "sudoku_solve.h"
+#include <stdbool.h>
+
+// The largest sudoku size a transformation can describe.
+#define CANON_MAX_SIZE 9
+
+// The most orders of lines with tied clue counts canonicalize_sudoku tries, for every orientation.
+#define CANON_MAX_ORDERINGS 1024
+
+/*
+    A transformation taking a sudoku to its canonical form.
+
+    Cell (i, j) of the canonical form holds digits[v], where v is the value of the original cell at
+    (rows[i], cols[j]), or at (cols[j], rows[i]) if the sudoku was transposed.
+*/
+typedef struct {
+    unsigned size; //< the size of the transformed sudoku
+    bool transposed; //< if rows and columns were swapped
+    unsigned rows[CANON_MAX_SIZE * CANON_MAX_SIZE]; //< the original row (or column) of every canonical row
+    unsigned cols[CANON_MAX_SIZE * CANON_MAX_SIZE]; //< the original column (or row) of every canonical column
+    int digits[CANON_MAX_SIZE * CANON_MAX_SIZE + 1]; //< the canonical label of every original digit (0 stays 0)
+} sudoku_transform;
+
+/*
+    An in-memory cache of solve results, keyed by the canonical form of the solved sudoku.
+*/
+typedef struct solve_cache solve_cache;
+
+/*******************
+ *  Canonical form *
+ *******************/
+
+/*
+    Computes the canonical form of a sudoku.
+
+    The form is found by ordering bands, stacks, rows and columns by clue counts (which don't
+    change under any of the symmetries), labeling digits in the order they first appear, and
+    keeping the smallest sudoku, cell by cell, over the sudoku and its transpose and every order
+    of the lines whose counts tie. Equivalent sudokus get the same form, unless their ties allow
+    more than CANON_MAX_ORDERINGS orders, in which case the tied lines keep their order and only
+    identical or relabeled sudokus are sure to. Either way the returned transformation is exact,
+    so results can always be mapped back.
+
+    \param s the sudoku to canonicalize (of size CANON_MAX_SIZE or less)
+    \param transform filled in with the transformation that was applied
+
+    \return a new heap-allocated sudoku holding the canonical form
+*/
+sudoku *canonicalize_sudoku(const sudoku *s, sudoku_transform *transform);
+
+/*
+    Maps a sudoku in canonical coordinates (for example the solution of a canonical form) back
+    to the coordinates of the sudoku the transformation was computed for.
+
+    \param canonical the sudoku to map back
+    \param transform the transformation given by canonicalize_sudoku
+
+    \return a new heap-allocated sudoku in the original coordinates
+*/
+sudoku *undo_transform(const sudoku *canonical, const sudoku_transform *transform);
+
+/*****************
+ *  Result cache *
+ *****************/
+
+/*
+    Creates an empty cache. Once full, the oldest entries get evicted first.
+
+    \param capacity the maximum number of results to keep
+
+    \return a new heap-allocated cache
+*/
+solve_cache *create_solve_cache(unsigned capacity);
+
+/*
+    Frees a cache and all the results it holds.
+
+    \param cache the cache to be freed
+*/
+void free_solve_cache(solve_cache *cache);
+
+/*
+    Solves a sudoku with solve_sudoku, unless a sudoku with the same canonical form has been
+    solved before, in which case the stored result is mapped back instead.
+
+    The cache is not thread safe; every thread should use its own.
+
+    \param cache the cache to look in and to store new results in
+    \param input the sudoku to be solved
+
+    \return the same as solve_sudoku
+*/
+solve_result cached_solve_sudoku(solve_cache *cache, const sudoku *input);
+
+/*
+    Same as cached_solve_sudoku, but a sudoku not found in the cache is solved with
+    solve_sudoku_into in the caller's scratch memory, so the tables of successive searches reuse
+    the same memory instead of being allocated and freed every time.
+
+    \param cache the cache to look in and to store new results in
+    \param input the sudoku to be solved
+    \param scratch the working memory, of at least solve_scratch_size(input->size) bytes, or NULL
+                   to solve with solve_sudoku
+    \param scratchSize the size of the working memory
+
+    \return the same as solve_sudoku
+*/
+solve_result cached_solve_sudoku_into(solve_cache *cache, const sudoku *input, void *scratch, size_t scratchSize);
+
+/*
+    Writes all the results of a cache to a file.
+
+    \param cache the cache to save
+    \param path the file to write
+
+    \return 0 on success, -1 if writing the file failed
+*/
+int save_solve_cache(const solve_cache *cache, const char *path);
+
+/*
+    Adds the results saved in a file to a cache. A file that is damaged anywhere, including a
+    value out of range, adds nothing.
+
+    \param cache the cache to fill
+    \param path the file written by save_solve_cache
+
+    \return 0 on success, -1 if the file couldn't be read or isn't a saved cache
+*/
+int load_solve_cache(solve_cache *cache, const char *path);
+
+#endif /* end of include guard: SUDOKU_CANON_H */
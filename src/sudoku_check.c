@@ -1,28 +1,421 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include "sudoku_io.h"
 #include "sudoku_checking.h"
+#include <assert.h>
 #include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <unistd.h>
 
 static const char* INVALID_STRING = "INVALID";
 static const char* INCOMPLETE_STRING = "INCOMPLETE";
 static const char* COMPLETE_STRING = "COMPLETE";
+static const char* UNREADABLE_STRING = "UNREADABLE";
+
+// Number of grids of a stream that are checked together.
+static const unsigned STREAM_BATCH_SIZE = 4096;
+
+// Number of grids a worker takes at once, so the queue lock is rarely contended.
+static const unsigned CLAIM_SIZE = 16;
+
+// The outcome of a job whose grid couldn't be read, following the values of check_result.
+#define UNREADABLE (CR_COMPLETE + 1)
+
+/*
+    One grid to be checked: either the grid of a file, or a grid cut out of a stream.
+*/
+typedef struct {
+    const char *path; //< the file to read the grid from, or NULL for text cut out of a stream
+    char *text; //< the text of the grid, if it came from a stream
+    size_t length; //< the length of the text
+    int status; //< the check_result of the grid, or UNREADABLE
+} check_job;
+
+/*
+    A batch of jobs shared by the workers, which claim them in order.
+*/
+typedef struct {
+    check_job *jobs;
+    unsigned noJobs;
+    unsigned next; //< the first job no worker has claimed yet
+    pthread_mutex_t lock; //< guards `next`
+} check_batch;
 
-int main() {
-    sudoku * givenSudoku = read_sudoku(stdin);
+/*
+    Running totals over all the checked grids, indexed by status.
+*/
+typedef struct {
+    unsigned long counts[UNREADABLE + 1];
+} check_totals;
 
-    write_sudoku(stdout, givenSudoku);
+/*
+    Converts the status of a job to the word that gets printed.
 
-    switch(check_sudoku(givenSudoku)) {
+    \param status a check_result or UNREADABLE
+
+    \return the name of the status
+*/
+static const char *status_name(int status) {
+    switch(status) {
         case CR_COMPLETE:
-            printf("%s\n", COMPLETE_STRING);
-            break;
+            return COMPLETE_STRING;
         case CR_INCOMPLETE:
-            printf("%s\n", INCOMPLETE_STRING);
-            break;
+            return INCOMPLETE_STRING;
         case CR_INVALID:
-            printf("%s\n", INVALID_STRING);
-            break;
+            return INVALID_STRING;
+        default:
+            return UNREADABLE_STRING;
     }
+}
 
-    free_sudoku(givenSudoku);
+/*
+    Finds the size of a sudoku with a given number of cells.
+
+    \param noCells the number of cells
+
+    \return the size, or 0 if no sudoku has that many cells
+*/
+static unsigned size_of_cells(unsigned long noCells) {
+    for(unsigned long size = 1; size * size * size * size <= noCells; ++size) {
+        if(size * size * size * size == noCells) {
+            return size;
+        }
+    }
     return 0;
 }
+
+/*
+    Reads the single grid of a file, either in the input format (see read_sudoku) or as written
+    by write_sudoku, without the size, as in the .out files of the tests.
+
+    \param input the file to read
+
+    \return a new heap-allocated sudoku, or NULL if the file doesn't hold exactly one grid of
+            values in range
+*/
+static sudoku *read_grid_file(FILE *input) {
+    unsigned long capacity = 256;
+    unsigned long noValues = 0;
+    int *values = malloc(sizeof(int) * capacity);
+    assert(values != NULL);
+
+    int value;
+    while(fscanf(input, "%d", &value) == 1) {
+        if(noValues == capacity) {
+            capacity *= 2;
+            values = realloc(values, sizeof(int) * capacity);
+            assert(values != NULL);
+        }
+        values[noValues++] = value;
+    }
+
+    sudoku *s = NULL;
+    if(feof(input) && noValues > 0) {
+        // A leading size is told apart by the count: n^4 + 1 values can't also be a fourth power.
+        unsigned size = size_of_cells(noValues - 1);
+        const int *cells = values + 1;
+        if(size == 0 || (int) size != values[0]) {
+            size = size_of_cells(noValues);
+            cells = values;
+        }
+
+        if(size != 0) {
+            s = create_sudoku(size);
+            for(unsigned i = 0; i < get_no_cells(s); ++i) {
+                s->cells[i] = cells[i];
+            }
+            // Like read_sudoku, values the checks can't index are unreadable.
+            for(unsigned i = 0; i < get_no_cells(s); ++i) {
+                if(cells[i] < 0 || cells[i] > (int) (size * size)) {
+                    free_sudoku(s);
+                    s = NULL;
+                    break;
+                }
+            }
+        }
+    }
+
+    free(values);
+    return s;
+}
+
+/*
+    Reads and checks the grid of a job.
+
+    \param job the job to run, its status is filled in
+*/
+static void run_job(check_job *job) {
+    FILE *input = job->path != NULL ? fopen(job->path, "r") : fmemopen(job->text, job->length, "r");
+    if(input == NULL) {
+        if(job->path != NULL) {
+            perror(job->path);
+        }
+        job->status = UNREADABLE;
+        return;
+    }
+
+    sudoku *s = job->path != NULL ? read_grid_file(input) : read_sudoku(input);
+    fclose(input);
+
+    if(s == NULL) {
+        job->status = UNREADABLE;
+    }
+    else {
+        job->status = check_sudoku(s);
+        free_sudoku(s);
+    }
+}
+
+/*
+    Worker thread: claims jobs of the batch until there are none left.
+
+    \param args the shared check_batch
+*/
+static void *check_worker(void *args) {
+    check_batch *batch = args;
+
+    while(true) {
+        pthread_mutex_lock(&batch->lock);
+        unsigned first = batch->next;
+        unsigned last = first + CLAIM_SIZE < batch->noJobs ? first + CLAIM_SIZE : batch->noJobs;
+        batch->next = last;
+        pthread_mutex_unlock(&batch->lock);
+
+        if(first >= last) {
+            break;
+        }
+        for(unsigned i = first; i < last; ++i) {
+            run_job(&batch->jobs[i]);
+        }
+    }
+
+    return NULL;
+}
+
+/*
+    Runs all the jobs of a batch on a pool of threads, then prints their results in order.
+
+    \param jobs the jobs to run
+    \param noJobs the number of jobs
+    \param noThreads the number of threads to use
+    \param firstIndex the number printed for the first grid of a stream
+    \param totals the totals to add the results to
+*/
+static void check_all(check_job *jobs, unsigned noJobs, unsigned noThreads,
+                      unsigned long firstIndex, check_totals *totals) {
+    check_batch batch;
+    batch.jobs = jobs;
+    batch.noJobs = noJobs;
+    batch.next = 0;
+    pthread_mutex_init(&batch.lock, NULL);
+
+    if(noThreads > noJobs) {
+        noThreads = noJobs;
+    }
+    pthread_t threads[noThreads > 0 ? noThreads : 1];
+    for(unsigned i = 0; i < noThreads; ++i) {
+        pthread_create(&threads[i], NULL, check_worker, &batch);
+    }
+    for(unsigned i = 0; i < noThreads; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+    pthread_mutex_destroy(&batch.lock);
+
+    for(unsigned i = 0; i < noJobs; ++i) {
+        if(jobs[i].path != NULL) {
+            printf("%s %s\n", jobs[i].path, status_name(jobs[i].status));
+        }
+        else {
+            printf("%lu %s\n", firstIndex + i, status_name(jobs[i].status));
+        }
+        totals->counts[jobs[i].status]++;
+    }
+}
+
+/*
+    Cuts the text of the next grid out of a stream of concatenated grids, without parsing the
+    values: the first number gives the size, and then size^4 more numbers are copied.
+
+    \param input the stream to read from
+    \param text filled in with a new heap-allocated copy of the text of the grid
+    \param length filled in with the length of the text
+
+    \return false if the stream ended before another grid started
+*/
+static bool cut_next_grid(FILE *input, char **text, size_t *length) {
+    size_t capacity = 64;
+    size_t used = 0;
+    char *buffer = malloc(capacity);
+    assert(buffer != NULL);
+
+    unsigned long noTokens = 0;
+    unsigned long noTokensWanted = 1; // Only the size, until it's known.
+    int c = getc(input);
+    while(c != EOF && noTokens < noTokensWanted) {
+        while(c != EOF && isspace(c)) {
+            c = getc(input);
+        }
+        if(c == EOF) {
+            break;
+        }
+
+        unsigned long value = 0;
+        while(c != EOF && !isspace(c)) {
+            if(used + 2 > capacity) {
+                capacity *= 2;
+                buffer = realloc(buffer, capacity);
+                assert(buffer != NULL);
+            }
+            buffer[used++] = (char) c;
+            value = isdigit(c) ? value * 10 + (c - '0') : value;
+            c = getc(input);
+        }
+        buffer[used++] = ' ';
+
+        if(noTokens++ == 0) {
+            // A size read_sudoku rejects still has its cells cut out with it, so only its own grid
+            // is UNREADABLE. Past UINT8_MAX, where the grid would end is anyone's guess, and only
+            // the size is cut.
+            noTokensWanted += value > 0 && value <= UINT8_MAX ? value * value * value * value : 0;
+        }
+    }
+    if(c != EOF) {
+        ungetc(c, input);
+    }
+
+    if(noTokens == 0) {
+        free(buffer);
+        return false;
+    }
+
+    *text = buffer;
+    *length = used;
+    return true;
+}
+
+/*
+    Usage: sudoku_check [--threads N] [FILE... | -]
+           sudoku_check --stream [FILE]
+
+    Without files, checks the single sudoku given on the standard input and writes it back,
+    followed by its status.
+
+    Otherwise checks the sudoku in every FILE (with or without its size, so solver outputs can be
+    checked too), or with -, every sudoku of a stream of concatenated sudokus on the standard
+    input, and writes one status per line (prefixed by the file name, or the position of the
+    sudoku in the stream) followed by the totals. The sudokus are read and checked by N threads
+    (one per processor by default). A sudoku with a size out of range (see read_sudoku) or with
+    missing, non-numeric or out of range cells is UNREADABLE.
+
+    With --stream, checks the single sudoku in FILE, or on the standard input, as it is read,
+    without loading it (see check_sudoku_stream), and writes its status: INVALID as soon as a
+    duplicate is read, or UNREADABLE if the input ends early.
+*/
+int main(int argc, char **argv) {
+    if(argc > 1 && strcmp(argv[1], "--stream") == 0) {
+        FILE *input = argc > 2 ? fopen(argv[2], "r") : stdin;
+        if(argc > 3 || input == NULL) {
+            if(input == NULL) {
+                perror(argv[2]);
+            }
+            fprintf(stderr, "Usage: %s --stream [FILE]\n", argv[0]);
+            return 1;
+        }
+
+        check_result result;
+        bool readable = check_sudoku_stream(input, &result);
+        printf("%s\n", status_name(readable ? (int) result : UNREADABLE));
+        if(input != stdin) {
+            fclose(input);
+        }
+        return readable ? 0 : 1;
+    }
+
+    long noThreads = sysconf(_SC_NPROCESSORS_ONLN);
+    int firstFile = 1;
+    if(argc > 2 && strcmp(argv[1], "--threads") == 0) {
+        noThreads = strtol(argv[2], NULL, 10);
+        firstFile = 3;
+    }
+    if(noThreads < 1) {
+        noThreads = 1;
+    }
+
+    if(firstFile == argc) {
+        sudoku * givenSudoku = read_sudoku(stdin);
+        if(givenSudoku == NULL) {
+            return 1;
+        }
+
+        write_sudoku(stdout, givenSudoku);
+
+        switch(check_sudoku(givenSudoku)) {
+            case CR_COMPLETE:
+                printf("%s\n", COMPLETE_STRING);
+                break;
+            case CR_INCOMPLETE:
+                printf("%s\n", INCOMPLETE_STRING);
+                break;
+            case CR_INVALID:
+                printf("%s\n", INVALID_STRING);
+                break;
+        }
+
+        free_sudoku(givenSudoku);
+        return 0;
+    }
+
+    check_totals totals = {{0}};
+
+    if(argc - firstFile == 1 && strcmp(argv[firstFile], "-") == 0) {
+        check_job *jobs = malloc(sizeof(check_job) * STREAM_BATCH_SIZE);
+        assert(jobs != NULL);
+
+        unsigned long noChecked = 0;
+        bool more = true;
+        while(more) {
+            unsigned noJobs = 0;
+            while(noJobs < STREAM_BATCH_SIZE
+                    && (more = cut_next_grid(stdin, &jobs[noJobs].text, &jobs[noJobs].length))) {
+                jobs[noJobs++].path = NULL;
+            }
+
+            check_all(jobs, noJobs, noThreads, noChecked + 1, &totals);
+            noChecked += noJobs;
+
+            for(unsigned i = 0; i < noJobs; ++i) {
+                free(jobs[i].text);
+            }
+        }
+        free(jobs);
+    }
+    else {
+        unsigned noJobs = argc - firstFile;
+        check_job *jobs = malloc(sizeof(check_job) * noJobs);
+        assert(jobs != NULL);
+
+        for(unsigned i = 0; i < noJobs; ++i) {
+            jobs[i].path = argv[firstFile + i];
+            jobs[i].text = NULL;
+            jobs[i].length = 0;
+        }
+        check_all(jobs, noJobs, noThreads, 1, &totals);
+        free(jobs);
+    }
+
+    unsigned long noGrids = 0;
+    for(unsigned i = 0; i <= UNREADABLE; ++i) {
+        noGrids += totals.counts[i];
+    }
+    printf("TOTAL %lu %s %lu %s %lu %s %lu %s %lu\n", noGrids,
+           COMPLETE_STRING, totals.counts[CR_COMPLETE],
+           INCOMPLETE_STRING, totals.counts[CR_INCOMPLETE],
+           INVALID_STRING, totals.counts[CR_INVALID],
+           UNREADABLE_STRING, totals.counts[UNREADABLE]);
+
+    return totals.counts[UNREADABLE] == 0 ? 0 : 1;
+}
@@ -1,4 +1,12 @@
 #include "sudoku_checking.h"
+#include "sudoku_kernels.h"
+#include "sudoku_trace.h"
+#include <assert.h>
+#include <ctype.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 
 
 // Checking functions
@@ -55,6 +63,9 @@ check_result check_list(const int* values, unsigned size) {
     Else if we find any CR_INCOMPLETEs return CR_INCOMPLETE.
     Otherwise, return COMPLETE.
 
+    Sizes 2 to 9 are handed to their specialized kernel (see sudoku_kernels.h) instead, which
+    checks everything in a single pass over the cells.
+
     \param givenSudoku the sudoku to check_result
 
     \return CR_COMPLETE if the sudoku is valid and CR_COMPLETE
@@ -62,9 +73,15 @@ check_result check_list(const int* values, unsigned size) {
             CR_INCOMPLETE if it is not invalid, but there are some empty spaces in the sudoku.
     \sa check_list, check_result
 */
-check_result check_sudoku(const sudoku *givenSudoku) {
+static check_result check_sudoku_untraced(const sudoku *givenSudoku) {
     check_result result = CR_COMPLETE;
 
+    const sudoku_kernels *kernels = get_kernels(givenSudoku->size);
+    if(kernels != NULL && kernels->check_sudoku(givenSudoku->cells, &result)) {
+        return result;
+    }
+    result = CR_COMPLETE;
+
     const unsigned sectionSize = givenSudoku->size * givenSudoku->size;
 
     // Initialize an buffer to hold the retrieved values.
@@ -111,3 +128,111 @@ check_result check_sudoku(const sudoku *givenSudoku) {
     }
     return result;
 }
+
+// check_sudoku_untraced as a span of the trace (see sudoku_trace.h).
+check_result check_sudoku(const sudoku *givenSudoku) {
+    TRACE_BEGIN("check_sudoku");
+    check_result result = check_sudoku_untraced(givenSudoku);
+    TRACE_END("check_sudoku");
+    return result;
+}
+
+/*
+    Reads a whole number from a stream.
+
+    \param input the stream to read from
+    \param value filled in with the number
+
+    \return false if the stream ended, or the next word isn't a number
+*/
+static bool read_number(FILE *input, long *value) {
+    int c = getc(input);
+    while(c != EOF && isspace(c)) {
+        c = getc(input);
+    }
+    bool negative = c == '-';
+    if(negative) {
+        c = getc(input);
+    }
+    if(c == EOF || !isdigit(c)) {
+        return false;
+    }
+
+    *value = 0;
+    while(c != EOF && isdigit(c)) {
+        // Saturates, as anything this large is out of range anyway.
+        *value = *value < LONG_MAX / 10 ? *value * 10 + (c - '0') : LONG_MAX;
+        c = getc(input);
+    }
+    if(c != EOF) {
+        ungetc(c, input);
+    }
+    if(negative) {
+        *value = -*value;
+    }
+    return true;
+}
+
+/*
+    Sets the bit of a value in a bit set of several words.
+
+    \param set the bit set
+    \param value the value, from 1
+
+    \return false if the bit was already set
+*/
+static bool mark_seen(uint64_t *set, long value) {
+    const uint64_t bit = (uint64_t) 1 << ((value - 1) % 64);
+    uint64_t *word = &set[(value - 1) / 64];
+    if((*word & bit) != 0) {
+        return false;
+    }
+    *word |= bit;
+    return true;
+}
+
+bool check_sudoku_stream(FILE *input, check_result *result) {
+    long size;
+    if(!read_number(input, &size) || size <= 0 || size > UINT8_MAX) {
+        return false;
+    }
+
+    // A bit set of the values seen so far in every column, in every box of the current band and
+    // in the current row, all side after side.
+    const unsigned long sectionSize = size * size;
+    const unsigned long noWords = (sectionSize + 63) / 64;
+    uint64_t *columns = calloc(sectionSize * noWords, sizeof(uint64_t));
+    uint64_t *boxes = calloc(size * noWords, sizeof(uint64_t));
+    uint64_t *row = calloc(noWords, sizeof(uint64_t));
+    assert(columns != NULL && boxes != NULL && row != NULL);
+
+    bool readable = true;
+    *result = CR_COMPLETE;
+    for(unsigned long i = 0; i < sectionSize && readable && *result != CR_INVALID; ++i) {
+        if(i % size == 0) {
+            memset(boxes, 0, sizeof(uint64_t) * size * noWords);
+        }
+        memset(row, 0, sizeof(uint64_t) * noWords);
+
+        for(unsigned long j = 0; j < sectionSize; ++j) {
+            long value;
+            if(!read_number(input, &value)) {
+                readable = false;
+                break;
+            }
+            if(value == 0) {
+                *result = CR_INCOMPLETE;
+            }
+            else if(value < 0 || (unsigned long) value > sectionSize || !mark_seen(row, value) || !mark_seen(&columns[j * noWords], value)
+                    || !mark_seen(&boxes[(j / size) * noWords], value)) {
+                *result = CR_INVALID;
+                break;
+            }
+        }
+    }
+
+    free(columns);
+    free(boxes);
+    free(row);
+    return readable;
+}
@@ -2,6 +2,8 @@
 #define SUDOKU_CHECKING_H
 
 #include "sudoku.h"
+#include <stdbool.h>
+#include <stdio.h>
 
 
 typedef unsigned __int128 uint128_t;
@@ -40,4 +42,20 @@ check_result check_list(const int *values, unsigned size);
 */
 check_result check_sudoku(const sudoku *givenSudoku);
 
+/*
+    Checks a sudoku straight from a stream, in the format read by read_sudoku, without ever
+    holding its cells: values are checked as they are read, against a bit set per column, per box
+    of the current band and for the current row, so the memory used only grows with the number of
+    cells in a row squared, and a duplicate is reported as soon as it is read.
+
+    \param input the stream to read from
+    \param result filled in with the result, like check_sudoku: CR_INVALID as soon as a duplicate
+                  (or a value out of range) is read, in which case the rest of the sudoku is left
+                  unread
+
+    \return false if the stream ended or held something other than a number before the result
+            was known
+*/
+bool check_sudoku_stream(FILE *input, check_result *result);
+
 #endif /* end of include guard: SUDOKU_CHECKING_H */
@@ -0,0 +1,109 @@
+#include "sudoku_checkpoint.h"
+#include "sudoku_io.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// The first line of every position file.
+#define POSITION_MAGIC "DLX POSITION 1"
+
+// The most cells a sudoku read_sudoku accepts has, which no search can be deeper than.
+#define MAX_DEPTH (READ_MAX_SIZE * READ_MAX_SIZE * READ_MAX_SIZE * READ_MAX_SIZE)
+
+/*
+    Writes a sudoku preceded by its size, so read_sudoku can read it back.
+*/
+static void write_sized_sudoku(FILE *output, const sudoku *s) {
+    fprintf(output, "%u\n", s->size);
+    write_sudoku(output, s);
+}
+
+int save_search_position(const char *path, const search_position *position) {
+    // Written next to the file and renamed over it, which replaces it in one go.
+    char *temporaryPath = malloc(strlen(path) + 5);
+    assert(temporaryPath != NULL);
+    sprintf(temporaryPath, "%s.tmp", path);
+
+    FILE *file = fopen(temporaryPath, "w");
+    if(file == NULL) {
+        free(temporaryPath);
+        return -1;
+    }
+
+    fprintf(file, "%s\n%lu %d %u\n", POSITION_MAGIC, position->noNodes, position->noSolutions, position->depth);
+    for(unsigned i = 0; i < position->depth; ++i) {
+        fprintf(file, i == 0 ? "%u" : " %u", position->branches[i]);
+    }
+    fprintf(file, "\n");
+    write_sized_sudoku(file, position->puzzle);
+    if(position->solution != NULL) {
+        write_sized_sudoku(file, position->solution);
+    }
+
+    int status = ferror(file) ? -1 : 0;
+    if(fclose(file) != 0 || status != 0 || rename(temporaryPath, path) != 0) {
+        remove(temporaryPath);
+        status = -1;
+    }
+    free(temporaryPath);
+    return status;
+}
+
+search_position *load_search_position(const char *path) {
+    FILE *file = fopen(path, "r");
+    if(file == NULL) {
+        return NULL;
+    }
+
+    search_position *position = malloc(sizeof(search_position));
+    assert(position != NULL);
+    position->puzzle = NULL;
+    position->solution = NULL;
+    position->branches = NULL;
+
+    char magic[sizeof(POSITION_MAGIC)];
+    bool valid = fgets(magic, sizeof(magic), file) != NULL && strcmp(magic, POSITION_MAGIC) == 0
+        && fscanf(file, "%lu %d %u", &position->noNodes, &position->noSolutions, &position->depth) == 3
+        && position->noSolutions >= 0 && position->noSolutions <= 1 && position->depth <= MAX_DEPTH;
+
+    if(valid) {
+        position->branches = malloc(sizeof(unsigned) * (position->depth + 1));
+        assert(position->branches != NULL);
+        for(unsigned i = 0; i < position->depth && valid; ++i) {
+            valid = fscanf(file, "%u", &position->branches[i]) == 1;
+        }
+    }
+    if(valid) {
+        position->puzzle = read_sudoku(file);
+        valid = position->puzzle != NULL && position->depth <= get_no_cells(position->puzzle);
+    }
+    if(valid && position->noSolutions == 1) {
+        position->solution = read_sudoku(file);
+        valid = position->solution != NULL && position->solution->size == position->puzzle->size;
+        // A solution has every cell filled in.
+        const int noValues = (int) (position->puzzle->size * position->puzzle->size);
+        for(unsigned i = 0; valid && i < get_no_cells(position->solution); ++i) {
+            valid = position->solution->cells[i] >= 1 && position->solution->cells[i] <= noValues;
+        }
+    }
+    fclose(file);
+
+    if(!valid) {
+        free_search_position(position);
+        return NULL;
+    }
+    return position;
+}
+
+void free_search_position(search_position *position) {
+    if(position->puzzle != NULL) {
+        free_sudoku(position->puzzle);
+    }
+    if(position->solution != NULL) {
+        free_sudoku(position->solution);
+    }
+    free(position->branches);
+    free(position);
+}
@@ -0,0 +1,68 @@
+/*
+    \file sudoku_checkpoint.h
+    \brief Saving the position of a dancing links search to a file, and resuming from it
+
+    The search picks its columns deterministically, so the path from the root to the node being
+    visited is fully described by the index of the row taken at every depth. Every branch before
+    those, at every depth, has been fully explored, so a search resumed from the same sudoku can
+    skip straight to the node it was at, keeping the nodes counted and the solutions found so far.
+    A search that gets killed halfway can then be finished over several bounded runs.
+*/
+
+#ifndef SUDOKU_CHECKPOINT_H
+#define SUDOKU_CHECKPOINT_H
+
+#include "sudoku.h"
+
+/*
+    Where a search was when it saved its position.
+*/
+typedef struct {
+    sudoku *puzzle; //< the sudoku being solved
+    unsigned long noNodes; //< the number of search nodes visited before this one
+    int noSolutions; //< the number of solutions found so far (0 or 1)
+    sudoku *solution; //< the solution found so far, or NULL
+    unsigned depth; //< the depth of the node the search was about to visit
+    unsigned *branches; //< the index of the row taken at every depth above it, in search order
+} search_position;
+
+/*
+    Checkpointing settings of a search (see solve_options).
+*/
+typedef struct {
+    const char *path; //< the file the position is saved to
+    int requested; //< set it (a signal handler can) to save the position at the next search node;
+                   //  the search clears it once saved
+    int status; //< set to -1 by the search if saving the position failed
+    unsigned noSaved; //< the number of positions the search saved
+    const search_position *resume; //< the position to resume from, or NULL to start from the root
+} solve_checkpoint;
+
+/*
+    Saves a position to a file. The file is replaced as a whole, so it holds either the old or the
+    new position if the program is killed while saving.
+
+    \param path the file to save to
+    \param position the position to save
+
+    \return 0 on success, -1 on error
+*/
+int save_search_position(const char *path, const search_position *position);
+
+/*
+    Loads a position saved by save_search_position.
+
+    \param path the file to load from
+
+    \return a new heap-allocated position, or NULL if the file can't be read or isn't a position
+*/
+search_position *load_search_position(const char *path);
+
+/*
+    Frees a position returned by load_search_position.
+
+    \param position the position to free
+*/
+void free_search_position(search_position *position);
+
+#endif /* end of include guard: SUDOKU_CHECKPOINT_H */
@@ -0,0 +1,118 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "sudoku_io.h"
+#include "sudoku_protocol.h"
+#include <string.h>
+#include <unistd.h>
+
+/*
+    Reads the text response to a request.
+
+    \param input the stream to read from
+    \param size the size of the sudoku that was sent
+    \param status filled in with the answered status
+    \param solution filled in with a new heap-allocated solution if the status is SR_SOLVED
+
+    \return 0 on success, 1 if the server rejected the request (an ERROR line), -1 if the response
+            couldn't be read
+*/
+static int read_result_text(FILE *input, unsigned size, solve_status *status, sudoku **solution) {
+    char word[16];
+    if(fscanf(input, "%15s", word) != 1) {
+        return -1;
+    }
+
+    *solution = NULL;
+    if(strcmp(word, "SOLVED") == 0) {
+        *status = SR_SOLVED;
+        *solution = create_sudoku(size);
+        for(unsigned i = 0; i < get_no_cells(*solution); ++i) {
+            if(fscanf(input, "%d", &(*solution)->cells[i]) != 1) {
+                free_sudoku(*solution);
+                return -1;
+            }
+        }
+    }
+    else if(strcmp(word, "MULTIPLE") == 0) {
+        *status = SR_MULTIPLE;
+    }
+    else if(strcmp(word, "UNSOLVABLE") == 0) {
+        *status = SR_UNSOLVABLE;
+    }
+    else if(strcmp(word, "ABORTED") == 0) {
+        *status = SR_ABORTED;
+    }
+    else if(strcmp(word, "OUT_OF_MEMORY") == 0) {
+        *status = SR_NO_MEMORY;
+    }
+    else if(strcmp(word, "ERROR") == 0) {
+        return 1;
+    }
+    else {
+        return -1;
+    }
+    return 0;
+}
+
+/*
+    Usage: sudoku_client SOCKET [--binary]
+
+    Sends every sudoku given on the standard input to the server listening on SOCKET and prints
+    the answers in the text response format. With --binary the requests are sent as frames.
+    A request the server rejects is reported on the standard error, and ends the run with status 1.
+*/
+int main(int argc, char **argv) {
+    if(argc < 2 || (argc > 2 && strcmp(argv[2], "--binary") != 0)) {
+        fprintf(stderr, "Usage: %s SOCKET [--binary]\n", argv[0]);
+        return 1;
+    }
+    const int binary = argc > 2;
+
+    int fd = connect_to_socket(argv[1]);
+    if(fd < 0) {
+        perror(argv[1]);
+        return 1;
+    }
+    FILE *toServer = fdopen(fd, "w");
+    FILE *fromServer = fdopen(dup(fd), "r");
+
+    int status = 0;
+    sudoku *givenSudoku;
+    while((givenSudoku = read_sudoku(stdin)) != NULL) {
+        if(binary) {
+            write_sudoku_frame(toServer, givenSudoku);
+        }
+        else {
+            fprintf(toServer, "%u\n", givenSudoku->size);
+            write_sudoku(toServer, givenSudoku);
+        }
+        fflush(toServer);
+
+        solve_status result;
+        sudoku *solution;
+        int received = binary ? read_result_frame(fromServer, &result, &solution)
+                              : read_result_text(fromServer, givenSudoku->size, &result, &solution);
+        free_sudoku(givenSudoku);
+
+        if(received > 0) {
+            // The server closes the connection after a rejected request.
+            fprintf(stderr, "%s: ERROR: the server rejected the request\n", argv[0]);
+            status = 1;
+            break;
+        }
+        if(received != 0) {
+            fprintf(stderr, "%s: no answer from the server\n", argv[0]);
+            status = 1;
+            break;
+        }
+
+        write_result_text(stdout, result, solution);
+        if(solution != NULL) {
+            free_sudoku(solution);
+        }
+    }
+
+    fclose(toServer);
+    fclose(fromServer);
+    return status;
+}
@@ -0,0 +1,301 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "sudoku_corpus.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static const char CORPUS_MAGIC[4] = {'S', 'D', 'K', 'C'};
+static const uint32_t CORPUS_VERSION = 1;
+
+// magic + version + count + index offset
+#define CORPUS_HEADER_SIZE (4 + 4 + 8 + 8)
+
+/*
+    Computes the number of bits needed to store any cell value of a sudoku of the given size.
+
+    \param size the size of the sudoku
+
+    \return the number of bits per packed cell
+*/
+static unsigned bits_per_cell(unsigned size) {
+    unsigned maxValue = size * size;
+    unsigned bits = 0;
+    while((1u << bits) <= maxValue) {
+        bits++;
+    }
+    return bits;
+}
+
+/*
+    Computes the number of bytes a packed record of a sudoku of the given size takes.
+
+    \param size the size of the sudoku
+
+    \return the record length, including its size byte
+*/
+static size_t record_length(unsigned size) {
+    size_t noCells = (size_t) size * size * size * size;
+    return 1 + (noCells * bits_per_cell(size) + 7) / 8;
+}
+
+// Little-endian encoding helpers, so corpora can be shared between machines.
+static void put_u32(unsigned char *dest, uint32_t value) {
+    for(unsigned i = 0; i < 4; ++i) {
+        dest[i] = (unsigned char) (value >> (8 * i));
+    }
+}
+
+static void put_u64(unsigned char *dest, uint64_t value) {
+    for(unsigned i = 0; i < 8; ++i) {
+        dest[i] = (unsigned char) (value >> (8 * i));
+    }
+}
+
+static uint32_t get_u32(const unsigned char *src) {
+    uint32_t value = 0;
+    for(unsigned i = 0; i < 4; ++i) {
+        value |= (uint32_t) src[i] << (8 * i);
+    }
+    return value;
+}
+
+static uint64_t get_u64(const unsigned char *src) {
+    uint64_t value = 0;
+    for(unsigned i = 0; i < 8; ++i) {
+        value |= (uint64_t) src[i] << (8 * i);
+    }
+    return value;
+}
+
+/*
+    Writes the header of a corpus at the start of the given file.
+
+    \param file the corpus file
+    \param count the number of sudokus in the corpus
+    \param indexOffset where the index starts in the file
+*/
+static int write_header(FILE *file, uint64_t count, uint64_t indexOffset) {
+    unsigned char header[CORPUS_HEADER_SIZE];
+    memcpy(header, CORPUS_MAGIC, 4);
+    put_u32(header + 4, CORPUS_VERSION);
+    put_u64(header + 8, count);
+    put_u64(header + 16, indexOffset);
+
+    if(fseek(file, 0, SEEK_SET) != 0) {
+        return -1;
+    }
+    return fwrite(header, 1, CORPUS_HEADER_SIZE, file) == CORPUS_HEADER_SIZE ? 0 : -1;
+}
+
+// Writing
+
+corpus_writer *corpus_create(const char *path) {
+    FILE *file = fopen(path, "wb");
+    if(file == NULL) {
+        return NULL;
+    }
+
+    corpus_writer *writer = malloc(sizeof(corpus_writer));
+    assert(writer != NULL);
+
+    writer->file = file;
+    writer->count = 0;
+    writer->capacity = 1024;
+    writer->offsets = malloc(sizeof(uint64_t) * writer->capacity);
+    assert(writer->offsets != NULL);
+    writer->position = CORPUS_HEADER_SIZE;
+
+    // Reserve room for the header, it gets filled in by corpus_finish.
+    write_header(file, 0, 0);
+
+    return writer;
+}
+
+int corpus_append(corpus_writer *writer, const sudoku *s) {
+    assert(writer != NULL);
+    assert(s != NULL);
+    assert(s->size <= UINT8_MAX);
+
+    if(writer->count == writer->capacity) {
+        writer->capacity *= 2;
+        writer->offsets = realloc(writer->offsets, sizeof(uint64_t) * writer->capacity);
+        assert(writer->offsets != NULL);
+    }
+
+    const unsigned bits = bits_per_cell(s->size);
+    const unsigned noCells = get_no_cells(s);
+    const size_t length = record_length(s->size);
+    unsigned char record[length];
+
+    record[0] = (unsigned char) s->size;
+    size_t out = 1;
+    uint64_t pending = 0; // bits waiting to be written, least significant first
+    unsigned noPending = 0;
+    for(unsigned i = 0; i < noCells; ++i) {
+        pending |= (uint64_t) s->cells[i] << noPending;
+        noPending += bits;
+        while(noPending >= 8) {
+            record[out++] = (unsigned char) pending;
+            pending >>= 8;
+            noPending -= 8;
+        }
+    }
+    if(noPending > 0) {
+        record[out++] = (unsigned char) pending;
+    }
+    assert(out == length);
+
+    if(fwrite(record, 1, length, writer->file) != length) {
+        return -1;
+    }
+    writer->offsets[writer->count++] = writer->position;
+    writer->position += length;
+    return 0;
+}
+
+int corpus_finish(corpus_writer *writer) {
+    assert(writer != NULL);
+
+    int status = 0;
+    unsigned char entry[8];
+    for(uint64_t i = 0; i < writer->count; ++i) {
+        put_u64(entry, writer->offsets[i]);
+        if(fwrite(entry, 1, 8, writer->file) != 8) {
+            status = -1;
+        }
+    }
+
+    if(write_header(writer->file, writer->count, writer->position) != 0) {
+        status = -1;
+    }
+    if(fclose(writer->file) != 0) {
+        status = -1;
+    }
+
+    free(writer->offsets);
+    free(writer);
+    return status;
+}
+
+// Reading
+
+sudoku_corpus *corpus_open(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if(fd < 0) {
+        return NULL;
+    }
+
+    struct stat info;
+    if(fstat(fd, &info) != 0 || (size_t) info.st_size < CORPUS_HEADER_SIZE) {
+        close(fd);
+        return NULL;
+    }
+
+    size_t length = info.st_size;
+    void *mapping = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // The mapping stays valid after the descriptor is closed.
+    if(mapping == MAP_FAILED) {
+        return NULL;
+    }
+
+    const unsigned char *data = mapping;
+    uint64_t count = get_u64(data + 8);
+    uint64_t indexOffset = get_u64(data + 16);
+
+    if(memcmp(data, CORPUS_MAGIC, 4) != 0 || get_u32(data + 4) != CORPUS_VERSION
+            || indexOffset > length || count > (length - indexOffset) / 8) {
+        munmap(mapping, length);
+        return NULL;
+    }
+
+    // Records are read in order by most scans.
+    posix_madvise(mapping, length, POSIX_MADV_SEQUENTIAL);
+
+    sudoku_corpus *corpus = malloc(sizeof(sudoku_corpus));
+    assert(corpus != NULL);
+
+    corpus->data = data;
+    corpus->length = length;
+    corpus->count = count;
+    corpus->index = data + indexOffset;
+
+    return corpus;
+}
+
+/*
+    Finds the start of a record in the mapping.
+
+    \param corpus the corpus to look in
+    \param index which sudoku of the corpus
+
+    \return a pointer to the size byte of the record, or NULL if the record doesn't fit in the
+            file or has a size of 0
+*/
+static const unsigned char *record_at(const sudoku_corpus *corpus, uint64_t index) {
+    assert(index < corpus->count);
+    uint64_t offset = get_u64(corpus->index + 8 * index);
+    if(offset >= corpus->length || corpus->data[offset] == 0
+       || record_length(corpus->data[offset]) > corpus->length - offset) {
+        return NULL;
+    }
+    return corpus->data + offset;
+}
+
+unsigned corpus_sudoku_size(const sudoku_corpus *corpus, uint64_t index) {
+    const unsigned char *record = record_at(corpus, index);
+    return record != NULL ? record[0] : 0;
+}
+
+int corpus_decode(const sudoku_corpus *corpus, uint64_t index, sudoku *dest) {
+    const unsigned char *record = record_at(corpus, index);
+    if(record == NULL || dest->size != record[0]) {
+        return -1;
+    }
+
+    const unsigned bits = bits_per_cell(dest->size);
+    const uint64_t mask = (1u << bits) - 1;
+    const unsigned noCells = get_no_cells(dest);
+    const int noValues = (int) (dest->size * dest->size);
+
+    const unsigned char *in = record + 1;
+    uint64_t pending = 0;
+    unsigned noPending = 0;
+    for(unsigned i = 0; i < noCells; ++i) {
+        while(noPending < bits) {
+            pending |= (uint64_t) *in++ << noPending;
+            noPending += 8;
+        }
+        dest->cells[i] = (int) (pending & mask);
+        pending >>= bits;
+        noPending -= bits;
+        // The bits of a cell can hold more than the values of the sudoku.
+        if(dest->cells[i] > noValues) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+sudoku *corpus_read_sudoku(const sudoku_corpus *corpus, uint64_t index) {
+    const unsigned size = corpus_sudoku_size(corpus, index);
+    if(size == 0) {
+        return NULL;
+    }
+    sudoku *s = create_sudoku(size);
+    if(corpus_decode(corpus, index, s) != 0) {
+        free_sudoku(s);
+        return NULL;
+    }
+    return s;
+}
+
+void corpus_close(sudoku_corpus *corpus) {
+    assert(corpus != NULL);
+    munmap((void*) corpus->data, corpus->length);
+    free(corpus);
+}
@@ -0,0 +1,131 @@
+/*
+    \file sudoku_corpus.h
+    \brief A compact binary container holding many bit-packed sudokus
+
+    File layout (all integers little-endian):
+        - header: the magic "SDKC", a 32-bit version, the 64-bit number of sudokus and the
+          64-bit offset of the index
+        - records: for every sudoku, one byte with its size followed by its cells, each packed in
+          the smallest number of bits that can hold size^2 (7 bits for an 81x81 sudoku)
+        - index: one 64-bit record offset per sudoku
+
+    The index is written last so a corpus can be built in a single pass over its input.
+*/
+
+#ifndef SUDOKU_CORPUS_H
+#define SUDOKU_CORPUS_H
+
+#include "sudoku.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+    A corpus being written. Records are appended to the file as they arrive; only their offsets
+    are kept in memory until the corpus is closed.
+*/
+typedef struct {
+    FILE *file; //< the file being written
+    uint64_t *offsets; //< the offset of every record written so far
+    uint64_t count; //< the number of records written so far
+    uint64_t capacity; //< the number of offsets that fit in `offsets`
+    uint64_t position; //< the offset the next record will be written at
+} corpus_writer;
+
+/*
+    A corpus opened for reading. The whole file is memory mapped, and sudokus are decoded
+    straight from the mapping.
+*/
+typedef struct {
+    const unsigned char *data; //< the mapped file
+    size_t length; //< the length of the mapping
+    uint64_t count; //< the number of sudokus in the corpus
+    const unsigned char *index; //< the record offsets, inside the mapping
+} sudoku_corpus;
+
+/*************
+ *  Writing  *
+ *************/
+
+/*
+    Creates a new, empty corpus file.
+
+    \param path where to create the file
+
+    \return a new heap-allocated writer, or NULL if the file couldn't be created
+*/
+corpus_writer *corpus_create(const char *path);
+
+/*
+    Appends a sudoku to the corpus.
+
+    \param writer the corpus to append to
+    \param s the sudoku to append
+
+    \return 0 on success, -1 if writing the file failed
+*/
+int corpus_append(corpus_writer *writer, const sudoku *s);
+
+/*
+    Writes the index and the header, then closes the file and frees the writer.
+
+    \param writer the writer to finish
+
+    \return 0 on success, -1 if writing the file failed
+*/
+int corpus_finish(corpus_writer *writer);
+
+/*************
+ *  Reading  *
+ *************/
+
+/*
+    Maps a corpus file into memory.
+
+    \param path the file to open
+
+    \return a new heap-allocated corpus, or NULL if the file couldn't be mapped or isn't a corpus
+*/
+sudoku_corpus *corpus_open(const char *path);
+
+/*
+    Returns the size of the given sudoku without decoding its cells.
+
+    \param corpus the corpus to look in
+    \param index which sudoku of the corpus (less than corpus->count)
+
+    \return the size of that sudoku, or 0 if its record is corrupt
+*/
+unsigned corpus_sudoku_size(const sudoku_corpus *corpus, uint64_t index);
+
+/*
+    Decodes a sudoku of the corpus into an existing sudoku of the same size.
+
+    \param corpus the corpus to read from
+    \param index which sudoku of the corpus (less than corpus->count)
+    \param dest the sudoku to fill in, which must have the size given by corpus_sudoku_size
+
+    \return 0 on success, -1 if the record is corrupt (including a value larger than the sudoku
+            has) or of another size than dest, in which case dest is left partly filled in
+*/
+int corpus_decode(const sudoku_corpus *corpus, uint64_t index, sudoku *dest);
+
+/*
+    Decodes a sudoku of the corpus, like read_sudoku does for a text stream.
+
+    \param corpus the corpus to read from
+    \param index which sudoku of the corpus (less than corpus->count)
+
+    \return a pointer of a new heap-allocated sudoku containing the decoded values, or NULL if
+            its record is corrupt
+*/
+sudoku *corpus_read_sudoku(const sudoku_corpus *corpus, uint64_t index);
+
+/*
+    Unmaps the corpus and frees it.
+
+    \param corpus the corpus to close
+*/
+void corpus_close(sudoku_corpus *corpus);
+
+#endif /* end of include guard: SUDOKU_CORPUS_H */
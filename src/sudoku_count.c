@@ -0,0 +1,296 @@
+#include "sudoku_count.h"
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Largest number of bytes of keys kept in the memo; past that, new counts are no longer kept.
+#define MEMO_MAX_BYTES (256u << 20)
+
+/*
+    Memo of the number of ways to complete the bands below a complete band, keyed by the digits
+    used in every column. An open addressing hash table.
+*/
+typedef struct {
+    uint128_t *keys; //< the column masks of every entry, side after side
+    uint128_t *counts; //< the count of every entry
+    unsigned *bands; //< the first band left to fill of every entry, 0 for an empty slot
+    size_t capacity; //< the number of slots, a power of two
+    size_t noEntries;
+    size_t maxEntries; //< stop adding entries past this many
+} count_memo;
+
+typedef struct {
+    unsigned size;
+    unsigned side; //< the number of cells in a row, column or box, and of digits
+    int *cells; //< the sudoku being filled in
+    uint128_t *rowUsed; //< the digits used in every row, digit d being bit d - 1
+    uint128_t *colUsed; //< the digits used in every column
+    uint128_t *boxUsed; //< the digits used in every box
+    uint128_t missing; //< the digits missing from the givens
+    uint128_t missingUsed; //< the missing digits placed so far
+    count_memo memo;
+    unsigned long noMemoHits;
+    bool overflow;
+} count_state;
+
+static unsigned popcount(uint128_t x) {
+    return __builtin_popcountll((uint64_t) x) + __builtin_popcountll((uint64_t) (x >> 64));
+}
+
+static unsigned lowest_bit_index(uint128_t x) {
+    return (uint64_t) x != 0 ? __builtin_ctzll((uint64_t) x) : 64 + __builtin_ctzll((uint64_t) (x >> 64));
+}
+
+/*
+    Adds two counts, noting an overflow.
+*/
+static uint128_t add_counts(count_state *state, uint128_t a, uint128_t b) {
+    if(a + b < a) {
+        state->overflow = true;
+    }
+    return a + b;
+}
+
+/*
+    Multiplies two counts, noting an overflow.
+*/
+static uint128_t multiply_counts(count_state *state, uint128_t a, uint128_t b) {
+    if(a != 0 && (a * b) / a != b) {
+        state->overflow = true;
+    }
+    return a * b;
+}
+
+static size_t hash_key(const uint128_t *key, unsigned side, unsigned band) {
+    uint64_t hash = 14695981039346656037u ^ band;
+    for(unsigned i = 0; i < side; ++i) {
+        hash = (hash ^ (uint64_t) key[i]) * 1099511628211u;
+        hash = (hash ^ (uint64_t) (key[i] >> 64)) * 1099511628211u;
+    }
+    return hash ^ (hash >> 29);
+}
+
+/*
+    Finds the slot of a key: the one holding it, or the empty one it would go in.
+*/
+static size_t find_slot(const count_memo *memo, const uint128_t *key, unsigned side, unsigned band) {
+    size_t slot = hash_key(key, side, band) & (memo->capacity - 1);
+    while(memo->bands[slot] != 0
+          && !(memo->bands[slot] == band && memcmp(&memo->keys[slot * side], key, sizeof(uint128_t) * side) == 0)) {
+        slot = (slot + 1) & (memo->capacity - 1);
+    }
+    return slot;
+}
+
+static void allocate_memo(count_memo *memo, size_t capacity, unsigned side) {
+    memo->capacity = capacity;
+    memo->keys = malloc(sizeof(uint128_t) * side * capacity);
+    memo->counts = malloc(sizeof(uint128_t) * capacity);
+    memo->bands = calloc(capacity, sizeof(unsigned));
+    assert(memo->keys != NULL && memo->counts != NULL && memo->bands != NULL);
+}
+
+/*
+    Doubles the number of slots of the memo.
+*/
+static void grow_memo(count_memo *memo, unsigned side) {
+    count_memo old = *memo;
+    allocate_memo(memo, old.capacity * 2, side);
+    for(size_t i = 0; i < old.capacity; ++i) {
+        if(old.bands[i] != 0) {
+            size_t slot = find_slot(memo, &old.keys[i * side], side, old.bands[i]);
+            memcpy(&memo->keys[slot * side], &old.keys[i * side], sizeof(uint128_t) * side);
+            memo->counts[slot] = old.counts[i];
+            memo->bands[slot] = old.bands[i];
+        }
+    }
+    free(old.keys);
+    free(old.counts);
+    free(old.bands);
+}
+
+static void place(count_state *state, unsigned row, unsigned col, unsigned box, unsigned digit) {
+    const uint128_t bit = (uint128_t) 1 << (digit - 1);
+    state->cells[row * state->side + col] = digit;
+    state->rowUsed[row] |= bit;
+    state->colUsed[col] |= bit;
+    state->boxUsed[box] |= bit;
+}
+
+static void unplace(count_state *state, unsigned row, unsigned col, unsigned box, unsigned digit) {
+    const uint128_t bit = (uint128_t) 1 << (digit - 1);
+    state->cells[row * state->side + col] = 0;
+    state->rowUsed[row] &= ~bit;
+    state->colUsed[col] &= ~bit;
+    state->boxUsed[box] &= ~bit;
+}
+
+static uint128_t count_band(count_state *state, unsigned band);
+
+/*
+    Counts the ways to complete the bands from a given one on, all the bands above being complete.
+
+    \param state the state of the count
+    \param band the first band left to fill, 1 or more
+*/
+static uint128_t count_below(count_state *state, unsigned band) {
+    if(band == state->size) {
+        return 1;
+    }
+    // Every row of a complete band holds every digit, so the missing digits no longer matter.
+    assert(state->missingUsed == state->missing);
+
+    count_memo *memo = &state->memo;
+    size_t slot = find_slot(memo, state->colUsed, state->side, band);
+    if(memo->bands[slot] != 0) {
+        state->noMemoHits++;
+        return memo->counts[slot];
+    }
+
+    uint128_t count = count_band(state, band);
+
+    if(memo->noEntries < memo->maxEntries) {
+        if(2 * (memo->noEntries + 1) > memo->capacity) {
+            grow_memo(memo, state->side);
+            slot = find_slot(memo, state->colUsed, state->side, band);
+        }
+        memcpy(&memo->keys[slot * state->side], state->colUsed, sizeof(uint128_t) * state->side);
+        memo->counts[slot] = count;
+        memo->bands[slot] = band;
+        memo->noEntries++;
+    }
+    return count;
+}
+
+/*
+    Counts the ways to complete a band and the ones below it, the bands above being complete.
+    Only counts one solution of every class of solutions that only differ by the missing digits.
+
+    \param state the state of the count
+    \param band the band to fill
+*/
+static uint128_t count_band(count_state *state, unsigned band) {
+    const unsigned side = state->side;
+    const uint128_t allDigits = ((uint128_t) 1 << side) - 1;
+
+    // The empty cell of the band with the fewest candidates. The choice must not depend on the
+    // digits themselves, so that relabeling the missing digits leaves the search order unchanged.
+    unsigned bestRow = 0, bestCol = 0;
+    unsigned bestCount = side + 1;
+    uint128_t bestCandidates = 0;
+    for(unsigned row = band * state->size; row < (band + 1) * state->size && bestCount > 1; ++row) {
+        for(unsigned col = 0; col < side; ++col) {
+            if(state->cells[row * side + col] == 0) {
+                const unsigned box = (row / state->size) * state->size + col / state->size;
+                uint128_t candidates = allDigits & ~(state->rowUsed[row] | state->colUsed[col] | state->boxUsed[box]);
+                unsigned noCandidates = popcount(candidates);
+                if(noCandidates < bestCount) {
+                    bestRow = row;
+                    bestCol = col;
+                    bestCount = noCandidates;
+                    bestCandidates = candidates;
+                    if(noCandidates <= 1) {
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    if(bestCount == side + 1) {
+        return count_below(state, band + 1);
+    }
+
+    // Of the missing digits not placed yet, only the smallest may be placed next.
+    uint128_t unusedMissing = state->missing & ~state->missingUsed;
+    uint128_t candidates = bestCandidates & ~(unusedMissing & (unusedMissing - 1));
+
+    const unsigned box = (bestRow / state->size) * state->size + bestCol / state->size;
+    uint128_t count = 0;
+    while(candidates != 0) {
+        const unsigned digit = lowest_bit_index(candidates) + 1;
+        const uint128_t bit = candidates & -candidates;
+        candidates &= candidates - 1;
+
+        const uint128_t missingUsed = state->missingUsed;
+        state->missingUsed |= bit & state->missing;
+        place(state, bestRow, bestCol, box, digit);
+        count = add_counts(state, count, count_band(state, band));
+        unplace(state, bestRow, bestCol, box, digit);
+        state->missingUsed = missingUsed;
+    }
+    return count;
+}
+
+count_result count_solutions(const sudoku *s) {
+    assert(s->size >= 1 && s->size <= 9);
+    count_result result = {0, 0, 1, 0, false};
+    check_result check = check_sudoku(s);
+    if(check == CR_INVALID) {
+        return result;
+    }
+    if(check == CR_COMPLETE) {
+        result.noSolutions = result.noClasses = 1;
+        return result;
+    }
+
+    count_state state;
+    state.size = s->size;
+    state.side = s->size * s->size;
+    const unsigned side = state.side;
+    state.cells = malloc(sizeof(int) * side * side);
+    state.rowUsed = calloc(side, sizeof(uint128_t));
+    state.colUsed = calloc(side, sizeof(uint128_t));
+    state.boxUsed = calloc(side, sizeof(uint128_t));
+    assert(state.cells != NULL && state.rowUsed != NULL && state.colUsed != NULL && state.boxUsed != NULL);
+    state.missing = ((uint128_t) 1 << side) - 1;
+    state.missingUsed = 0;
+    state.noMemoHits = 0;
+    state.overflow = false;
+
+    memset(state.cells, 0, sizeof(int) * side * side);
+    for(unsigned row = 0; row < side; ++row) {
+        for(unsigned col = 0; col < side; ++col) {
+            int value = get_cell(s, row, col);
+            if(value != 0) {
+                place(&state, row, col, (row / s->size) * s->size + col / s->size, value);
+                state.missing &= ~((uint128_t) 1 << (value - 1));
+            }
+        }
+    }
+
+    state.memo.noEntries = 0;
+    state.memo.maxEntries = MEMO_MAX_BYTES / (sizeof(uint128_t) * (side + 1) + sizeof(unsigned));
+    allocate_memo(&state.memo, 1024, side);
+
+    result.noClasses = count_band(&state, 0);
+    for(unsigned i = 2; i <= popcount(state.missing); ++i) {
+        result.classSize = multiply_counts(&state, result.classSize, i);
+    }
+    result.noSolutions = multiply_counts(&state, result.noClasses, result.classSize);
+    result.noMemoHits = state.noMemoHits;
+    result.overflow = state.overflow;
+
+    free(state.memo.keys);
+    free(state.memo.counts);
+    free(state.memo.bands);
+    free(state.cells);
+    free(state.rowUsed);
+    free(state.colUsed);
+    free(state.boxUsed);
+    return result;
+}
+
+void write_count(FILE *output, uint128_t count) {
+    char digits[40];
+    unsigned noDigits = 0;
+    do {
+        digits[noDigits++] = '0' + (char) (count % 10);
+        count /= 10;
+    } while(count != 0);
+
+    while(noDigits > 0) {
+        fputc(digits[--noDigits], output);
+    }
+}
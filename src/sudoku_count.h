@@ -0,0 +1,56 @@
+/*
+    \file sudoku_count.h
+    \brief Counting all the solutions of a sudoku, using its symmetries to avoid enumerating them
+
+    The solvers stop at the second solution, and enumerating every solution of a sparse sudoku is
+    hopeless. Two things keep count_solutions from having to:
+
+     - The digits missing from the givens are interchangeable: relabeling them maps solutions onto
+       solutions, and no solution is mapped onto itself since every solution uses every digit. Only
+       the solutions in which the missing digits first appear in increasing order (in search order)
+       are counted, one per class, and the total is that count times the size of a class, the
+       factorial of the number of missing digits.
+
+     - Cells are filled band by band, and once a band is complete the number of ways to complete
+       the bands below only depends on the digits used in every column. Those counts are memoized,
+       so all the ways to fill a band that differ by the order of its rows, or in any other way
+       that leaves its columns with the same digits, are only followed through once.
+*/
+
+#ifndef SUDOKU_COUNT_H
+#define SUDOKU_COUNT_H
+
+#include "sudoku.h"
+#include "sudoku_checking.h"
+#include <stdbool.h>
+#include <stdio.h>
+
+/*
+    The result of counting the solutions of a sudoku.
+*/
+typedef struct {
+    uint128_t noSolutions; //< the number of solutions
+    uint128_t noClasses; //< the number of solutions up to relabeling the digits missing from the givens
+    uint128_t classSize; //< the number of solutions in every such class
+    unsigned long noMemoHits; //< the number of band completions answered by the memo
+    bool overflow; //< the numbers above didn't fit in 128 bits and are meaningless
+} count_result;
+
+/*
+    Counts all the solutions of a sudoku.
+
+    \param s the sudoku to count the solutions of (of size 9 or less)
+
+    \return the number of solutions, 0 if the givens break a rule
+*/
+count_result count_solutions(const sudoku *s);
+
+/*
+    Writes a count in decimal.
+
+    \param output the output stream to write to
+    \param count the count to write
+*/
+void write_count(FILE *output, uint128_t count);
+
+#endif /* end of include guard: SUDOKU_COUNT_H */
@@ -0,0 +1,111 @@
+#define _DEFAULT_SOURCE
+
+#include "sudoku_counters.h"
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
+static const char *const COUNTER_NAMES[NO_HARDWARE_COUNTERS] = {
+    "cycles", "instructions", "L1d-misses", "LLC-misses", "branch-misses"
+};
+
+/*
+    Opens a single counter of the calling thread and of the threads it starts afterwards.
+
+    \param counter the event to count
+
+    \return the file descriptor of the counter, or -1 if it isn't available
+*/
+static int open_counter(hardware_counter counter) {
+#ifdef __linux__
+    struct perf_event_attr attributes;
+    memset(&attributes, 0, sizeof(attributes));
+    attributes.size = sizeof(attributes);
+    attributes.type = PERF_TYPE_HARDWARE;
+    attributes.exclude_kernel = 1;
+    attributes.exclude_hv = 1;
+    // Tables of large sudokus are built by threads of their own, whose counts are added to the
+    // calling thread's once they exit; they're joined before the table is searched.
+    attributes.inherit = 1;
+    // Counters that had to share the processor's registers are scaled by the time they ran.
+    attributes.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    switch(counter) {
+        case HC_CYCLES:
+            attributes.config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+        case HC_INSTRUCTIONS:
+            attributes.config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+        case HC_L1D_MISSES:
+            attributes.type = PERF_TYPE_HW_CACHE;
+            attributes.config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                              | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            break;
+        case HC_LLC_MISSES:
+            attributes.config = PERF_COUNT_HW_CACHE_MISSES;
+            break;
+        case HC_BRANCH_MISSES:
+            attributes.config = PERF_COUNT_HW_BRANCH_MISSES;
+            break;
+    }
+
+    return (int) syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0);
+#else
+    (void) counter;
+    return -1;
+#endif
+}
+
+bool open_solve_counters(solve_counters *counters) {
+    bool available = false;
+    for(unsigned i = 0; i < NO_HARDWARE_COUNTERS; ++i) {
+        counters->fds[i] = open_counter((hardware_counter) i);
+        available |= counters->fds[i] >= 0;
+    }
+    reset_solve_counters(counters);
+    return available;
+}
+
+void close_solve_counters(solve_counters *counters) {
+    for(unsigned i = 0; i < NO_HARDWARE_COUNTERS; ++i) {
+        if(counters->fds[i] >= 0) {
+            close(counters->fds[i]);
+            counters->fds[i] = -1;
+        }
+    }
+}
+
+void reset_solve_counters(solve_counters *counters) {
+    memset(counters->table, 0, sizeof(counters->table));
+    memset(counters->search, 0, sizeof(counters->search));
+}
+
+void read_solve_counters(const solve_counters *counters, uint64_t values[NO_HARDWARE_COUNTERS]) {
+    for(unsigned i = 0; i < NO_HARDWARE_COUNTERS; ++i) {
+        // The value, the time enabled and the time running.
+        uint64_t reading[3];
+        values[i] = 0;
+        if(counters->fds[i] >= 0 && read(counters->fds[i], reading, sizeof(reading)) == sizeof(reading)) {
+            values[i] = reading[2] != 0 && reading[2] < reading[1]
+                      ? (uint64_t) ((double) reading[0] * reading[1] / reading[2]) : reading[0];
+        }
+    }
+}
+
+void add_solve_counts(const solve_counters *counters, const uint64_t since[NO_HARDWARE_COUNTERS],
+                      uint64_t counts[NO_HARDWARE_COUNTERS]) {
+    uint64_t now[NO_HARDWARE_COUNTERS];
+    read_solve_counters(counters, now);
+    for(unsigned i = 0; i < NO_HARDWARE_COUNTERS; ++i) {
+        counts[i] += now[i] >= since[i] ? now[i] - since[i] : 0;
+    }
+}
+
+const char *hardware_counter_name(hardware_counter counter) {
+    return COUNTER_NAMES[counter];
+}
@@ -0,0 +1,96 @@
+/*
+    \file sudoku_counters.h
+    \brief Hardware performance counters around the phases of a dancing links search
+
+    Wall time alone can't tell whether a change to the layout of the table pays off. A search given
+    a solve_counters (through solve_options) adds what the processor counted while it built its
+    table and while it searched it: cycles, instructions, L1 data and last level cache misses and
+    mispredicted branches. Divided by the number of search nodes, those give the cost of a node.
+
+    The counters are read with Linux's perf_event_open. Counters the processor, the kernel or its
+    settings (see /proc/sys/kernel/perf_event_paranoid) don't provide are left out, and elsewhere
+    none are available; the search runs the same either way.
+*/
+
+#ifndef SUDOKU_COUNTERS_H
+#define SUDOKU_COUNTERS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+    The events counted.
+*/
+typedef enum {
+    HC_CYCLES,
+    HC_INSTRUCTIONS,
+    HC_L1D_MISSES,     //< L1 data cache read misses
+    HC_LLC_MISSES,     //< last level cache misses
+    HC_BRANCH_MISSES   //< mispredicted branches
+} hardware_counter;
+
+// The number of values of hardware_counter.
+#define NO_HARDWARE_COUNTERS 5
+
+/*
+    The counters of a thread, and the counts of the searches it ran.
+*/
+typedef struct {
+    int fds[NO_HARDWARE_COUNTERS]; //< the open counters, -1 for the ones that aren't available
+    uint64_t table[NO_HARDWARE_COUNTERS]; //< the counts while building tables, added up
+    uint64_t search[NO_HARDWARE_COUNTERS]; //< the counts while searching, added up
+} solve_counters;
+
+/*
+    Opens the counters of the calling thread, which only count while it runs, and zeroes the
+    counts. The threads it starts afterwards are counted too, once they have exited.
+
+    \param counters the counters to open
+
+    \return true if at least one counter is available
+*/
+bool open_solve_counters(solve_counters *counters);
+
+/*
+    Closes the counters opened by open_solve_counters.
+
+    \param counters the counters to close
+*/
+void close_solve_counters(solve_counters *counters);
+
+/*
+    Zeroes the counts, to measure another search.
+
+    \param counters the counters
+*/
+void reset_solve_counters(solve_counters *counters);
+
+/*
+    Reads the current value of every counter, 0 for the ones that aren't available. Only the
+    differences between two readings on the thread that opened them mean something.
+
+    \param counters the counters to read
+    \param values filled in with the value of every counter
+*/
+void read_solve_counters(const solve_counters *counters, uint64_t values[NO_HARDWARE_COUNTERS]);
+
+/*
+    Adds what was counted since an earlier reading to some counts.
+
+    \param counters the counters to read
+    \param since the earlier reading
+    \param counts the counts to add to (table or search)
+*/
+void add_solve_counts(const solve_counters *counters, const uint64_t since[NO_HARDWARE_COUNTERS],
+                      uint64_t counts[NO_HARDWARE_COUNTERS]);
+
+/*
+    Gives the name of a counter, as reported by sudoku_perf.
+
+    \param counter the counter
+
+    \return a name without spaces
+*/
+const char *hardware_counter_name(hardware_counter counter);
+
+#endif /* end of include guard: SUDOKU_COUNTERS_H */
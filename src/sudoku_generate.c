@@ -0,0 +1,340 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "sudoku_io.h"
+#include "sudoku_solve.h"
+#include "sudoku_portfolio.h"
+#include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <time.h>
+
+// Default search node budget of a single uniqueness check.
+static const unsigned long DEFAULT_MAX_NODES = 10000;
+
+// Smallest size whose uniqueness checks run their two searches in parallel. The checks of
+// smaller sudokus take a few microseconds, less than starting a thread does.
+static const unsigned THREADED_CHECK_MIN_SIZE = 4;
+
+/*
+    Small xorshift random number generator. Every worker owns one, so no
+    locking is needed when drawing random numbers.
+*/
+typedef struct {
+    uint64_t state;
+} rng;
+
+/*
+    Shared state of a generation run.
+*/
+typedef struct {
+    unsigned size; //< the size of the sudokus to generate
+    unsigned count; //< the number of sudokus to generate
+    unsigned started; //< the number of sudokus a worker has started generating
+    unsigned long maxNodes; //< search node budget of every uniqueness check
+    bool threadedChecks; //< run the two searches of a uniqueness check in parallel
+    pthread_mutex_t lock; //< guards `started` and the output stream
+    FILE *output; //< where the generated sudokus are written
+} generate_state;
+
+typedef struct {
+    generate_state *shared;
+    rng random;
+} worker_args;
+
+/*
+    Draws the next random number from the generator.
+
+    \param r the generator to advance
+
+    \return a 64-bit random value
+*/
+static uint64_t rng_next(rng *r) {
+    uint64_t x = r->state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    r->state = x;
+    return x;
+}
+
+/*
+    Draws a random number in the range [0, bound).
+*/
+static unsigned rng_below(rng *r, unsigned bound) {
+    return (unsigned) (rng_next(r) % bound);
+}
+
+/*
+    Shuffles an array of unsigned values in place (Fisher-Yates).
+
+    \param r the generator to use
+    \param values the values to shuffle
+    \param noValues the number of values in the array
+*/
+static void shuffle(rng *r, unsigned *values, unsigned noValues) {
+    for(unsigned i = noValues; i > 1; --i) {
+        unsigned j = rng_below(r, i);
+        unsigned tmp = values[i - 1];
+        values[i - 1] = values[j];
+        values[j] = tmp;
+    }
+}
+
+/*
+    Fills a buffer with a random permutation of size*size indexes that only
+    moves whole bands around and rows (or columns) within their band, so
+    applying it keeps a valid sudoku valid.
+
+    \param r the generator to use
+    \param size the size of the sudoku
+    \param dest buffer of size*size values to be filled
+*/
+static void random_band_permutation(rng *r, unsigned size, unsigned *dest) {
+    unsigned bands[size];
+    unsigned inBand[size];
+
+    for(unsigned i = 0; i < size; ++i) {
+        bands[i] = i;
+    }
+    shuffle(r, bands, size);
+
+    for(unsigned b = 0; b < size; ++b) {
+        for(unsigned i = 0; i < size; ++i) {
+            inBand[i] = i;
+        }
+        shuffle(r, inBand, size);
+        for(unsigned i = 0; i < size; ++i) {
+            dest[b * size + i] = bands[b] * size + inBand[i];
+        }
+    }
+}
+
+/*
+    Applies a random validity preserving transformation to a sudoku: digit
+    relabeling, band/stack permutation, row/column permutation within their
+    band/stack and transposition.
+
+    \param r the generator to use
+    \param s the sudoku to transform in place
+*/
+static void shuffle_grid(rng *r, sudoku *s) {
+    const unsigned sectionSize = s->size * s->size;
+    unsigned digits[sectionSize];
+    unsigned rows[sectionSize];
+    unsigned cols[sectionSize];
+
+    for(unsigned i = 0; i < sectionSize; ++i) {
+        digits[i] = i + 1;
+    }
+    shuffle(r, digits, sectionSize);
+    random_band_permutation(r, s->size, rows);
+    random_band_permutation(r, s->size, cols);
+    const int transpose = rng_below(r, 2);
+
+    sudoku *original = copy_sudoku(s);
+    for(unsigned row = 0; row < sectionSize; ++row) {
+        for(unsigned col = 0; col < sectionSize; ++col) {
+            int value = transpose ? get_cell(original, cols[col], rows[row])
+                                  : get_cell(original, rows[row], cols[col]);
+            set_cell(s, row, col, value == 0 ? 0 : (int) digits[value - 1]);
+        }
+    }
+    free_sudoku(original);
+}
+
+/*
+    Creates a random complete sudoku.
+
+    The boxes on the main diagonal don't share any row or column, so they are
+    filled with independent random permutations and the exact cover solver
+    completes the rest of the grid. The result is then shuffled to spread it
+    over its whole symmetry class.
+
+    \param r the generator to use
+    \param size the size of the sudoku
+    \param maxNodes search node budget for completing the grid
+
+    \return a new heap-allocated complete sudoku
+*/
+static sudoku *random_full_grid(rng *r, unsigned size, unsigned long maxNodes) {
+    const unsigned sectionSize = size * size;
+    unsigned values[sectionSize];
+
+    sudoku *seed = create_sudoku(size);
+    for(unsigned i = 0; i < get_no_cells(seed); ++i) {
+        seed->cells[i] = 0;
+    }
+
+    for(unsigned box = 0; box < size; ++box) {
+        for(unsigned i = 0; i < sectionSize; ++i) {
+            values[i] = i + 1;
+        }
+        shuffle(r, values, sectionSize);
+        for(unsigned i = 0; i < sectionSize; ++i) {
+            set_cell(seed, box * size + i / size, box * size + i % size, values[i]);
+        }
+    }
+
+    solve_result result = solve_sudoku_bounded(seed, maxNodes);
+    sudoku *grid;
+    if(result.solution == NULL) {
+        // Fall back to the canonical pattern grid, which is always valid.
+        grid = seed;
+        for(unsigned row = 0; row < sectionSize; ++row) {
+            for(unsigned col = 0; col < sectionSize; ++col) {
+                set_cell(grid, row, col, ((row % size) * size + row / size + col) % sectionSize + 1);
+            }
+        }
+    }
+    else {
+        grid = result.solution;
+        free_sudoku(seed);
+    }
+
+    shuffle_grid(r, grid);
+    return grid;
+}
+
+/*
+    Generates a puzzle with exactly one solution.
+
+    Starting from a random complete grid, clues are removed in a random order.
+    After each removal the puzzle is solved again and the clue is put back if
+    the solution stopped being unique, or if proving it unique takes more than
+    the node budget (which is what keeps the large sizes tractable). Uniqueness
+    is checked by comparing the first solutions in ascending and descending
+    value order (see solve_sudoku_dual), which on a unique puzzle stops long
+    before going through the whole search tree.
+
+    \param r the generator to use
+    \param size the size of the sudoku
+    \param maxNodes search node budget of each of the two searches of a uniqueness check
+    \param threadedChecks run the two searches in parallel
+
+    \return a new heap-allocated sudoku with a unique solution
+*/
+static sudoku *generate_puzzle(rng *r, unsigned size, unsigned long maxNodes, bool threadedChecks) {
+    sudoku *puzzle = random_full_grid(r, size, maxNodes);
+    const unsigned noCells = get_no_cells(puzzle);
+
+    unsigned *order = malloc(sizeof(unsigned) * noCells);
+    assert(order != NULL);
+    for(unsigned i = 0; i < noCells; ++i) {
+        order[i] = i;
+    }
+    shuffle(r, order, noCells);
+
+    for(unsigned i = 0; i < noCells; ++i) {
+        int removed = puzzle->cells[order[i]];
+        puzzle->cells[order[i]] = 0;
+
+        solve_options options = {maxNodes, false, NULL, NULL, NULL, NULL, NULL, false};
+        solve_result result = solve_sudoku_dual(puzzle, &options, threadedChecks);
+        if(result.solution != NULL) {
+            free_sudoku(result.solution);
+        }
+        if(result.status != SR_SOLVED) {
+            puzzle->cells[order[i]] = removed;
+        }
+    }
+
+    free(order);
+    return puzzle;
+}
+
+/*
+    Worker thread body: keeps generating puzzles until the requested count has
+    been reached, writing each one out as soon as it is done.
+
+    \param arg a worker_args structure
+*/
+static void *generate_worker(void *arg) {
+    worker_args *args = arg;
+    generate_state *shared = args->shared;
+
+    for(;;) {
+        pthread_mutex_lock(&shared->lock);
+        int done = shared->started >= shared->count;
+        shared->started++;
+        pthread_mutex_unlock(&shared->lock);
+        if(done) {
+            break;
+        }
+
+        sudoku *puzzle = generate_puzzle(&args->random, shared->size, shared->maxNodes, shared->threadedChecks);
+
+        pthread_mutex_lock(&shared->lock);
+        fprintf(shared->output, "%u\n", puzzle->size);
+        write_sudoku(shared->output, puzzle);
+        pthread_mutex_unlock(&shared->lock);
+
+        free_sudoku(puzzle);
+    }
+
+    return NULL;
+}
+
+/*
+    Usage: sudoku_generate SIZE [COUNT] [THREADS] [SEED] [NODES]
+
+    Writes COUNT puzzles of the given size, each with exactly one solution, to
+    the standard output in the same format read_sudoku accepts. NODES bounds
+    each of the two searches of every uniqueness check (0 for no bound); lower
+    values give puzzles with more clues, but finish faster on the large sizes.
+    When fewer puzzles are generated at once than half the cores, the two
+    searches of every check of a sudoku of size 4 or more run in parallel.
+*/
+int main(int argc, char **argv) {
+    if(argc < 2) {
+        fprintf(stderr, "Usage: %s SIZE [COUNT] [THREADS] [SEED] [NODES]\n", argv[0]);
+        return 1;
+    }
+
+    unsigned size = strtoul(argv[1], NULL, 10);
+    unsigned count = argc > 2 ? strtoul(argv[2], NULL, 10) : 1;
+    const long noCores = sysconf(_SC_NPROCESSORS_ONLN);
+    long noThreads = argc > 3 ? strtol(argv[3], NULL, 10) : noCores;
+    uint64_t seed = argc > 4 ? strtoull(argv[4], NULL, 10) : (uint64_t) time(NULL);
+    unsigned long maxNodes = argc > 5 ? strtoul(argv[5], NULL, 10) : DEFAULT_MAX_NODES;
+
+    if(size < 2 || size > 9) {
+        fprintf(stderr, "SIZE must be between 2 and 9\n");
+        return 1;
+    }
+    if(noThreads < 1) {
+        noThreads = 1;
+    }
+
+    generate_state shared;
+    shared.size = size;
+    shared.count = count;
+    shared.started = 0;
+    shared.maxNodes = maxNodes;
+    // One after the other, the two searches of a check cost about as much as a single search
+    // through the whole tree, so they only pay off on cores the workers leave idle.
+    const unsigned long noBusyThreads = (unsigned long) noThreads < count ? (unsigned long) noThreads : count;
+    shared.threadedChecks = size >= THREADED_CHECK_MIN_SIZE && 2 * noBusyThreads <= (unsigned long) noCores;
+    shared.output = stdout;
+    pthread_mutex_init(&shared.lock, NULL);
+
+    pthread_t threads[noThreads];
+    worker_args args[noThreads];
+
+    for(long i = 0; i < noThreads; ++i) {
+        args[i].shared = &shared;
+        // Mix the worker index in so that every worker gets a distinct, non-zero state.
+        args[i].random.state = (seed + 1) * 0x9E3779B97F4A7C15ULL + (uint64_t) i * 0xBF58476D1CE4E5B9ULL;
+        if(args[i].random.state == 0) {
+            args[i].random.state = 1;
+        }
+        pthread_create(&threads[i], NULL, generate_worker, &args[i]);
+    }
+
+    for(long i = 0; i < noThreads; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+
+    pthread_mutex_destroy(&shared.lock);
+    return 0;
+}
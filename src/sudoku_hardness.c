@@ -0,0 +1,172 @@
+#include "sudoku_hardness.h"
+#include "sudoku_checking.h"
+#include <assert.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+// Sudokus with more values than this have no masks to propagate with, and are only counted.
+#define HARDNESS_MAX_SECTION 128
+
+// Sudokus of this size or less are solved in a few microseconds whatever their givens, about as
+// long as measuring them would take, so they're only estimated by their number of cells.
+#define HARDNESS_MIN_SIZE 3
+
+/*
+    An empty cell, with the sections it belongs to.
+*/
+typedef struct {
+    unsigned row;
+    unsigned col;
+    unsigned box;
+} blank_cell;
+
+typedef struct {
+    uint128_t *rowUsed; //< the values used in every row, value v being bit v - 1
+    uint128_t *colUsed; //< the values used in every column
+    uint128_t *boxUsed; //< the values used in every box
+    uint128_t all; //< every value
+    blank_cell *blanks; //< the cells still empty
+    unsigned noBlanks;
+} hardness_state;
+
+static unsigned popcount(uint128_t x) {
+    return __builtin_popcountll((uint64_t) x) + __builtin_popcountll((uint64_t) (x >> 64));
+}
+
+static uint128_t candidates_of(const hardness_state *state, const blank_cell *blank) {
+    return state->all & ~(state->rowUsed[blank->row] | state->colUsed[blank->col] | state->boxUsed[blank->box]);
+}
+
+/*
+    Places a value, returning false if its row, column or box already has it.
+*/
+static bool place(hardness_state *state, unsigned row, unsigned col, unsigned box, uint128_t bit) {
+    if(((state->rowUsed[row] | state->colUsed[col] | state->boxUsed[box]) & bit) != 0) {
+        return false;
+    }
+    state->rowUsed[row] |= bit;
+    state->colUsed[col] |= bit;
+    state->boxUsed[box] |= bit;
+    return true;
+}
+
+/*
+    Fills in the cells left with a single candidate, sweeping over the empty cells until a sweep
+    fills none in. The filled cells are dropped from the list, so every sweep is shorter.
+
+    \return false if a cell was left without candidates
+*/
+static bool fill_naked_singles(hardness_state *state) {
+    bool placed = true;
+    while(placed) {
+        placed = false;
+        unsigned noLeft = 0;
+        for(unsigned i = 0; i < state->noBlanks; ++i) {
+            const blank_cell blank = state->blanks[i];
+            const uint128_t candidates = candidates_of(state, &blank);
+            if(candidates == 0) {
+                return false;
+            }
+            if((candidates & (candidates - 1)) == 0) {
+                place(state, blank.row, blank.col, blank.box, candidates);
+                placed = true;
+            }
+            else {
+                state->blanks[noLeft++] = blank;
+            }
+        }
+        state->noBlanks = noLeft;
+    }
+    return true;
+}
+
+void measure_hardness(const sudoku *s, hardness_features *features) {
+    const unsigned size = s->size;
+    const unsigned side = size * size;
+    const unsigned noCells = side * side;
+
+    *features = (hardness_features){0, 0, 0, 0, 0, false};
+    for(unsigned i = 0; i < noCells; ++i) {
+        if(s->cells[i] == 0) {
+            features->noBlanks++;
+        }
+    }
+    features->noClues = noCells - features->noBlanks;
+    if(side > HARDNESS_MAX_SECTION) {
+        features->noCandidates = (unsigned long) features->noBlanks * side;
+        features->noUnresolved = features->noBlanks;
+        features->freedom = features->noCandidates - features->noBlanks;
+        return;
+    }
+
+    hardness_state state;
+    state.rowUsed = calloc(3 * side, sizeof(uint128_t));
+    state.blanks = malloc(sizeof(blank_cell) * (features->noBlanks + 1));
+    assert(state.rowUsed != NULL && state.blanks != NULL);
+    state.colUsed = state.rowUsed + side;
+    state.boxUsed = state.colUsed + side;
+    state.all = side == 128 ? ~(uint128_t) 0 : ((uint128_t) 1 << side) - 1;
+    state.noBlanks = 0;
+
+    // Walks the cells band by band and box by box, still row by row, so no box takes a division.
+    bool alive = true;
+    for(unsigned band = 0; band < size; ++band) {
+        for(unsigned row = band * size; row < (band + 1) * size; ++row) {
+            for(unsigned box = band * size; box < (band + 1) * size; ++box) {
+                for(unsigned col = box % size * size; col < (box % size + 1) * size; ++col) {
+                    const int value = s->cells[row * side + col];
+                    if(value == 0) {
+                        state.blanks[state.noBlanks++] = (blank_cell){row, col, box};
+                    }
+                    else {
+                        alive = alive && value > 0 && (unsigned) value <= side
+                                && place(&state, row, col, box, (uint128_t) 1 << (value - 1));
+                    }
+                }
+            }
+        }
+    }
+    for(unsigned i = 0; i < state.noBlanks && alive; ++i) {
+        features->noCandidates += popcount(candidates_of(&state, &state.blanks[i]));
+    }
+
+    alive = alive && fill_naked_singles(&state);
+    for(unsigned i = 0; i < state.noBlanks && alive; ++i) {
+        features->noUnresolved++;
+        features->freedom += popcount(candidates_of(&state, &state.blanks[i])) - 1;
+    }
+    features->deadEnd = !alive;
+
+    free(state.blanks);
+    free(state.rowUsed);
+}
+
+unsigned long estimate_hardness(const sudoku *s) {
+    const unsigned long noCells = (unsigned long) s->size * s->size * s->size * s->size;
+    if(s->size <= HARDNESS_MIN_SIZE) {
+        return noCells;
+    }
+
+    hardness_features features;
+    measure_hardness(s, &features);
+
+    // Building the exact cover table takes a time proportional to the cells and the candidates.
+    const unsigned long table = noCells + features.noCandidates;
+    if(features.deadEnd || features.noUnresolved == 0) {
+        return table;
+    }
+
+    // The search is what takes orders of magnitude longer on some sudokus than on others. The
+    // sudokus of every size tried got suddenly harder once the cells left after the naked singles
+    // had about four extra candidates on average, so the search is counted as 2^(extra^2 / 2) per
+    // cell left, with extra the average number of extra candidates, in quarters of a power of two.
+    const unsigned long long freedom = features.freedom;
+    const unsigned long long noUnresolved = features.noUnresolved;
+    const unsigned long long quarters = 2 * freedom * freedom / (noUnresolved * noUnresolved);
+    if(quarters / 4 >= 40) {
+        return ULONG_MAX;
+    }
+    const unsigned long search = (noUnresolved * (4 + quarters % 4) / 4) << (quarters / 4);
+    return table + search;
+}
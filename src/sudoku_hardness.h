@@ -0,0 +1,51 @@
+/*
+    \file sudoku_hardness.h
+    \brief A cheap estimate of how long a sudoku takes to solve
+
+    The times of the puzzles of a batch span several orders of magnitude, and a hard puzzle taken
+    last by a pool of workers keeps the whole batch waiting. estimate_hardness looks at a sudoku
+    without searching it: the number of blanks and of candidates, which the size of the exact
+    cover table follows, and what is left once every cell with a single candidate is filled in,
+    which the search has to guess.
+*/
+
+#ifndef SUDOKU_HARDNESS_H
+#define SUDOKU_HARDNESS_H
+
+#include "sudoku.h"
+#include <stdbool.h>
+
+/*
+    What estimate_hardness finds out about a sudoku.
+*/
+typedef struct {
+    unsigned noClues; //< the number of cells given
+    unsigned noBlanks; //< the number of empty cells
+    unsigned long noCandidates; //< the number of values the empty cells can take, given the clues
+    unsigned noUnresolved; //< the number of cells still empty once the naked singles are filled in
+    unsigned long freedom; //< the number of candidates of those cells beyond their first
+    bool deadEnd; //< if the clues clash, or the naked singles leave a cell without candidates
+} hardness_features;
+
+/*
+    Looks at a sudoku the way estimate_hardness does. The blanks of a sudoku with more than 128
+    values are only counted, each taken to have every value as a candidate.
+
+    \param s the sudoku to look at
+    \param features filled in with what was found
+*/
+void measure_hardness(const sudoku *s, hardness_features *features);
+
+/*
+    Estimates the cost of solving a sudoku, in arbitrary units that only mean something compared
+    with each other, across all sizes. Meant to order a batch, not to predict times: the cost of
+    a search can't be told for sure without running it, so the order is right on the whole rather
+    than for every pair of sudokus. Sudokus of size 3 or less are all estimated the same.
+
+    \param s the sudoku to estimate
+
+    \return the estimate, larger for sudokus expected to take longer
+*/
+unsigned long estimate_hardness(const sudoku *s);
+
+#endif /* end of include guard: SUDOKU_HARDNESS_H */
@@ -1,35 +1,59 @@
 #include "sudoku_io.h"
+#include "sudoku_trace.h"
 #include <assert.h>
+#include <string.h>
 
 // I/O
 
 /*
     Reads a sudoku from a given input stream.
-    This assumes the sudoku is given in a correct format:
-        - size of the sudoku on the first line
+    This expects the sudoku in the following format:
+        - size of the sudoku on the first line, from 1 to READ_MAX_SIZE
         - size^2 other lines, each containing size^2 space separated values representing the value
             of that cell of the sudoku, or 0 if the cell is empty
 
+    Several sudokus can be read one after the other from the same stream.
+
     /param input the input stream to read from
+    /param status set to READ_OK, READ_END if the stream ended before another sudoku started, or
+                  READ_MALFORMED if the size is out of range or a cell is missing, not a number or
+                  not a value of the sudoku
 
-    /return a pointer of a new heap-allocated sudoku containing the read values
+    /return a pointer of a new heap-allocated sudoku containing the read values, or NULL if none
+            was read
 */
-sudoku *read_sudoku(FILE *inputFile) {
-    unsigned size;
-    fscanf(inputFile, "%d", &size);
+sudoku *read_sudoku_checked(FILE *inputFile, read_status *status) {
+    TRACE_BEGIN("read_sudoku");
+    int size;
+    int read = fscanf(inputFile, "%d", &size);
+    if(read != 1 || size < 1 || size > READ_MAX_SIZE) {
+        *status = read == EOF ? READ_END : READ_MALFORMED;
+        TRACE_END("read_sudoku");
+        return NULL;
+    }
     sudoku *s = create_sudoku(size);
+    const int noValues = size * size;
 
-    for(unsigned i = 0; i < size * size; ++i) {
-        for(unsigned j = 0; j < size * size; ++j) {
-            unsigned value;
-            fscanf(inputFile, "%d", &value);
-            set_cell(s, i, j, value);
+    for(unsigned i = 0; i < get_no_cells(s); ++i) {
+        // The solvers and checks index bit sets by value, so every value has to be in range.
+        if(fscanf(inputFile, "%d", &s->cells[i]) != 1 || s->cells[i] < 0 || s->cells[i] > noValues) {
+            free_sudoku(s);
+            *status = READ_MALFORMED;
+            TRACE_END("read_sudoku");
+            return NULL;
         }
     }
 
+    *status = READ_OK;
+    TRACE_END("read_sudoku");
     return s;
 }
 
+sudoku *read_sudoku(FILE *inputFile) {
+    read_status status;
+    return read_sudoku_checked(inputFile, &status);
+}
+
 
 /*
     Writes a given sudoku to the given output stream.
@@ -39,6 +63,7 @@ sudoku *read_sudoku(FILE *inputFile) {
     /param givenSudoku the sudoku to write to the output stream
 */
 void write_sudoku(FILE *outputFile, const sudoku *sudoku) {
+    TRACE_BEGIN("write_sudoku");
     assert(sudoku != NULL);
 
     unsigned size = sudoku->size;
@@ -50,4 +75,142 @@ void write_sudoku(FILE *outputFile, const sudoku *sudoku) {
         }
         fprintf(outputFile, "\n");
     }
+    TRACE_END("write_sudoku");
+}
+
+// Single line format
+
+// Longest line read_sudoku_line accepts (a 25x25 sudoku), plus the new line and terminator.
+#define MAX_LINE_LENGTH (625 + 2)
+
+static const char LINE_DIGITS[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+/*
+    Converts a character of the single line format to the value of its cell.
+
+    \param c the character to convert
+
+    \return the value of the cell, 0 for an empty one, or -1 if the character is not valid
+*/
+static int line_value(char c) {
+    if(c == '.' || c == '0') {
+        return 0;
+    }
+    if(c >= '1' && c <= '9') {
+        return c - '0';
+    }
+    if(c >= 'A' && c <= 'Z') {
+        return c - 'A' + 10;
+    }
+    if(c >= 'a' && c <= 'z') {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+/*
+    Reads a sudoku written on a single line from a given input stream.
+    Each character of the line is a cell, in row-major order: '1'-'9' and then 'A'-'Z' (or 'a'-'z')
+    for the values 10 to 35, and '.' or '0' for an empty cell. The size is worked out from the length
+    of the line, so 16, 81, 256 and 625 characters are read as sudokus of size 2, 3, 4 and 5.
+    Empty lines are skipped. Lines of any other length, or with a character that isn't a cell
+    value, are malformed (with a message on stderr).
+
+    /param input the input stream to read from
+    /param status set to READ_OK, READ_END if the stream ended before another sudoku started, or
+                  READ_MALFORMED if the line read isn't a sudoku
+
+    /return a pointer of a new heap-allocated sudoku containing the read values, or NULL if none
+            was read
+*/
+static sudoku *read_sudoku_line_untraced(FILE *inputFile, read_status *status) {
+    char line[MAX_LINE_LENGTH + 1];
+
+    while(fgets(line, sizeof(line), inputFile) != NULL) {
+        size_t length = strcspn(line, "\r\n");
+        if(length == 0) {
+            continue;
+        }
+
+        if(line[length] == '\0' && !feof(inputFile)) {
+            // Too long to be a sudoku, skip the rest of the line.
+            int c;
+            while((c = fgetc(inputFile)) != '\n' && c != EOF);
+            fprintf(stderr, "line too long to be a sudoku\n");
+            *status = READ_MALFORMED;
+            return NULL;
+        }
+
+        unsigned size = 2;
+        while(size * size * size * size < length) {
+            size++;
+        }
+        if(size * size * size * size != length || size > 5) {
+            fprintf(stderr, "line of length %zu, which is not a sudoku\n", length);
+            *status = READ_MALFORMED;
+            return NULL;
+        }
+
+        sudoku *s = create_sudoku(size);
+        int valid = 1;
+        for(size_t i = 0; i < length; ++i) {
+            int value = line_value(line[i]);
+            if(value < 0 || value > (int) (size * size)) {
+                valid = 0;
+                break;
+            }
+            s->cells[i] = value;
+        }
+        if(valid) {
+            *status = READ_OK;
+            return s;
+        }
+
+        fprintf(stderr, "line with a character that is not a cell value\n");
+        free_sudoku(s);
+        *status = READ_MALFORMED;
+        return NULL;
+    }
+
+    *status = READ_END;
+    return NULL;
+}
+
+// read_sudoku_line_untraced as a span of the trace (see sudoku_trace.h).
+sudoku *read_sudoku_line_checked(FILE *inputFile, read_status *status) {
+    TRACE_BEGIN("read_sudoku_line");
+    sudoku *s = read_sudoku_line_untraced(inputFile, status);
+    TRACE_END("read_sudoku_line");
+    return s;
+}
+
+sudoku *read_sudoku_line(FILE *inputFile) {
+    read_status status;
+    sudoku *s;
+    while((s = read_sudoku_line_checked(inputFile, &status)) == NULL && status == READ_MALFORMED);
+    return s;
+}
+
+/*
+    Writes a given sudoku to the given output stream on a single line, in the format read by
+    read_sudoku_line. Empty cells are written as '.'.
+
+    /param output the output stream to write to
+    /param givenSudoku the sudoku to write to the output stream (of size 5 or less)
+*/
+void write_sudoku_line(FILE *outputFile, const sudoku *sudoku) {
+    TRACE_BEGIN("write_sudoku_line");
+    assert(sudoku != NULL);
+    assert(sudoku->size <= 5);
+
+    const unsigned noCells = get_no_cells(sudoku);
+    char line[MAX_LINE_LENGTH];
+
+    for(unsigned i = 0; i < noCells; ++i) {
+        int value = sudoku->cells[i];
+        line[i] = value == 0 ? '.' : LINE_DIGITS[value];
+    }
+    line[noCells] = '\n';
+    fwrite(line, 1, noCells + 1, outputFile);
+    TRACE_END("write_sudoku_line");
 }
@@ -5,16 +5,44 @@
 
 // I/O
 
+// Largest size read_sudoku accepts (an 81x81 sudoku), which keeps a bad size from asking for an
+// enormous allocation.
+#define READ_MAX_SIZE 9
+
+/*
+    The outcome of reading a sudoku.
+*/
+typedef enum {
+    READ_OK, //< a sudoku was read
+    READ_END, //< the stream ended before another sudoku started
+    READ_MALFORMED //< the size is out of range, or a cell is missing, not a number or out of range
+} read_status;
+
 /*
     Reads a sudoku from a given input stream.
-    This assumes the sudoku is given in a correct format:
-        - size of the sudoku on the first line
+    This expects the sudoku in the following format:
+        - size of the sudoku on the first line, from 1 to READ_MAX_SIZE
         - size^2 other lines, each containing size^2 space separated values representing the value
-            of that cell of the sudoku, or 0 if the cell is empty
+            of that cell of the sudoku (from 1 to size^2), or 0 if the cell is empty
+
+    Several sudokus can be read one after the other from the same stream.
+
+    /param input the input stream to read from
+    /param status set to why no sudoku was read, if none was (see read_status)
+
+    /return a pointer of a new heap-allocated sudoku containing the read values, or NULL if the
+            stream ended or the sudoku is malformed
+*/
+sudoku *read_sudoku_checked(FILE *input, read_status *status);
+
+/*
+    Reads a sudoku from a given input stream, like read_sudoku_checked, for callers that handle
+    a malformed sudoku like the end of the stream.
 
     /param input the input stream to read from
 
-    /return a pointer of a new heap-allocated sudoku containing the read values
+    /return a pointer of a new heap-allocated sudoku containing the read values, or NULL if the
+            stream ended or the sudoku is malformed
 */
 sudoku *read_sudoku(FILE *input);
 
@@ -27,4 +55,41 @@ sudoku *read_sudoku(FILE *input);
 */
 void write_sudoku(FILE *output, const sudoku *givenSudoku);
 
+/*
+    Reads a sudoku written on a single line from a given input stream.
+    Each character of the line is a cell, in row-major order: '1'-'9' and then 'A'-'Z' (or 'a'-'z')
+    for the values 10 to 35, and '.' or '0' for an empty cell. The size is worked out from the length
+    of the line, so 16, 81, 256 and 625 characters are read as sudokus of size 2, 3, 4 and 5.
+    Empty lines are skipped. Lines of any other length, or with a character that isn't a cell
+    value, are malformed (with a message on stderr), so a caller answering every line can still
+    answer them in place.
+
+    /param input the input stream to read from
+    /param status set to why no sudoku was read, if none was (see read_status)
+
+    /return a pointer of a new heap-allocated sudoku containing the read values, or NULL if the
+            stream ended or the line is malformed
+*/
+sudoku *read_sudoku_line_checked(FILE *input, read_status *status);
+
+/*
+    Reads a sudoku written on a single line from a given input stream, like
+    read_sudoku_line_checked, skipping the malformed lines.
+
+    /param input the input stream to read from
+
+    /return a pointer of a new heap-allocated sudoku containing the read values, or NULL if the
+            stream ended before another sudoku started
+*/
+sudoku *read_sudoku_line(FILE *input);
+
+/*
+    Writes a given sudoku to the given output stream on a single line, in the format read by
+    read_sudoku_line. Empty cells are written as '.'.
+
+    /param output the output stream to write to
+    /param givenSudoku the sudoku to write to the output stream (of size 5 or less)
+*/
+void write_sudoku_line(FILE *output, const sudoku *givenSudoku);
+
 #endif
@@ -0,0 +1,105 @@
+/*
+    \file sudoku_kernel_template.h
+    \brief One instance of the kernels of sudoku_kernels.h
+
+    Included by sudoku_kernels.c once per size, with KERNEL_SIZE set to the size and KERNEL_MASK to
+    an unsigned type with at least KERNEL_SIZE^2 bits. Value v is kept as bit v-1 of a mask.
+*/
+
+#define KERNEL_CONCAT_(name, size) name##size
+#define KERNEL_CONCAT(name, size) KERNEL_CONCAT_(name, size)
+#define KERNEL_NAME(name) KERNEL_CONCAT(name, KERNEL_SIZE)
+
+#define KERNEL_WIDTH (KERNEL_SIZE * KERNEL_SIZE)
+
+/*
+    Checks a whole sudoku in a single pass, keeping a mask of the values seen so far in every row,
+    column and box.
+*/
+static bool KERNEL_NAME(check_sudoku_)(const int *cells, check_result *result) {
+    KERNEL_MASK rows[KERNEL_WIDTH] = {0};
+    KERNEL_MASK cols[KERNEL_WIDTH] = {0};
+    KERNEL_MASK boxes[KERNEL_WIDTH] = {0};
+    bool complete = true;
+    bool invalid = false;
+
+    for(unsigned row = 0; row < KERNEL_WIDTH; ++row) {
+        const unsigned boxRow = (row / KERNEL_SIZE) * KERNEL_SIZE;
+        for(unsigned col = 0; col < KERNEL_WIDTH; ++col) {
+            const int value = cells[row * KERNEL_WIDTH + col];
+            if(value == 0) {
+                complete = false;
+                continue;
+            }
+            if(value < 0 || value > KERNEL_WIDTH) {
+                return false;
+            }
+
+            const KERNEL_MASK bit = (KERNEL_MASK) 1 << (value - 1);
+            const unsigned box = boxRow + col / KERNEL_SIZE;
+            if(((rows[row] | cols[col] | boxes[box]) & bit) != 0) {
+                invalid = true; // Keep going, a later value could still be out of range.
+            }
+            rows[row] |= bit;
+            cols[col] |= bit;
+            boxes[box] |= bit;
+        }
+    }
+
+    *result = invalid ? CR_INVALID : complete ? CR_COMPLETE : CR_INCOMPLETE;
+    return true;
+}
+
+/*
+    Checks the row, column and box of a cell for duplicates, reading the cells in place.
+*/
+static bool KERNEL_NAME(check_update_)(const int *cells, unsigned index) {
+    const unsigned row = index / KERNEL_WIDTH;
+    const unsigned col = index % KERNEL_WIDTH;
+    const int *rowCells = cells + row * KERNEL_WIDTH;
+    const int *boxCells = cells + (row / KERNEL_SIZE) * KERNEL_SIZE * KERNEL_WIDTH
+                                + (col / KERNEL_SIZE) * KERNEL_SIZE;
+    KERNEL_MASK rowSeen = 0;
+    KERNEL_MASK colSeen = 0;
+    KERNEL_MASK boxSeen = 0;
+
+    for(unsigned i = 0; i < KERNEL_WIDTH; ++i) {
+        const int rowValue = rowCells[i];
+        const int colValue = cells[i * KERNEL_WIDTH + col];
+        const int boxValue = boxCells[(i / KERNEL_SIZE) * KERNEL_WIDTH + i % KERNEL_SIZE];
+
+        if(rowValue != 0) {
+            const KERNEL_MASK bit = (KERNEL_MASK) 1 << (rowValue - 1);
+            if((rowSeen & bit) != 0) {
+                return false;
+            }
+            rowSeen |= bit;
+        }
+        if(colValue != 0) {
+            const KERNEL_MASK bit = (KERNEL_MASK) 1 << (colValue - 1);
+            if((colSeen & bit) != 0) {
+                return false;
+            }
+            colSeen |= bit;
+        }
+        if(boxValue != 0) {
+            const KERNEL_MASK bit = (KERNEL_MASK) 1 << (boxValue - 1);
+            if((boxSeen & bit) != 0) {
+                return false;
+            }
+            boxSeen |= bit;
+        }
+    }
+    return true;
+}
+
+static const sudoku_kernels KERNEL_NAME(kernels_) = {
+    KERNEL_SIZE,
+    KERNEL_NAME(check_sudoku_),
+    KERNEL_NAME(check_update_)
+};
+
+#undef KERNEL_WIDTH
+#undef KERNEL_NAME
+#undef KERNEL_CONCAT
+#undef KERNEL_CONCAT_
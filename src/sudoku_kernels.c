@@ -0,0 +1,75 @@
+#include "sudoku_kernels.h"
+#include <stdint.h>
+
+// Instantiate the kernels for every size, each with the narrowest mask holding size^2 bits.
+
+#define KERNEL_SIZE 2
+#define KERNEL_MASK uint8_t
+#include "sudoku_kernel_template.h"
+#undef KERNEL_MASK
+#undef KERNEL_SIZE
+
+#define KERNEL_SIZE 3
+#define KERNEL_MASK uint16_t
+#include "sudoku_kernel_template.h"
+#undef KERNEL_MASK
+#undef KERNEL_SIZE
+
+#define KERNEL_SIZE 4
+#define KERNEL_MASK uint16_t
+#include "sudoku_kernel_template.h"
+#undef KERNEL_MASK
+#undef KERNEL_SIZE
+
+#define KERNEL_SIZE 5
+#define KERNEL_MASK uint32_t
+#include "sudoku_kernel_template.h"
+#undef KERNEL_MASK
+#undef KERNEL_SIZE
+
+#define KERNEL_SIZE 6
+#define KERNEL_MASK uint64_t
+#include "sudoku_kernel_template.h"
+#undef KERNEL_MASK
+#undef KERNEL_SIZE
+
+#define KERNEL_SIZE 7
+#define KERNEL_MASK uint64_t
+#include "sudoku_kernel_template.h"
+#undef KERNEL_MASK
+#undef KERNEL_SIZE
+
+#define KERNEL_SIZE 8
+#define KERNEL_MASK uint64_t
+#include "sudoku_kernel_template.h"
+#undef KERNEL_MASK
+#undef KERNEL_SIZE
+
+#define KERNEL_SIZE 9
+#define KERNEL_MASK uint128_t
+#include "sudoku_kernel_template.h"
+#undef KERNEL_MASK
+#undef KERNEL_SIZE
+
+const sudoku_kernels *get_kernels(unsigned size) {
+    switch(size) {
+        case 2:
+            return &kernels_2;
+        case 3:
+            return &kernels_3;
+        case 4:
+            return &kernels_4;
+        case 5:
+            return &kernels_5;
+        case 6:
+            return &kernels_6;
+        case 7:
+            return &kernels_7;
+        case 8:
+            return &kernels_8;
+        case 9:
+            return &kernels_9;
+        default:
+            return NULL;
+    }
+}
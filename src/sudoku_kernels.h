@@ -0,0 +1,58 @@
+/*
+    \file sudoku_kernels.h
+    \brief Check kernels specialized for every sudoku size from 2 to 9
+
+    The generic functions in sudoku.h and sudoku_checking.h work for any size, so all their loop
+    bounds, divisions and modulos depend on a runtime value. The kernels declared here are
+    instantiated once per size from sudoku_kernel_template.h, with constant bounds and the
+    narrowest bit set type holding a value of that size, and work on the cells array directly.
+*/
+
+#ifndef SUDOKU_KERNELS_H
+#define SUDOKU_KERNELS_H
+
+#include "sudoku.h"
+#include "sudoku_checking.h"
+#include <stdbool.h>
+
+// The sizes with a specialized instance.
+#define KERNELS_MIN_SIZE 2
+#define KERNELS_MAX_SIZE 9
+
+/*
+    The kernels of one size.
+*/
+typedef struct {
+    unsigned size; //< the size these kernels were specialized for
+
+    /*
+        Checks a whole sudoku, like check_sudoku.
+
+        \param cells the cells of the sudoku
+        \param result filled in with the check result
+
+        \return false if a cell holds a value outside of 0..size^2, which the kernels don't handle
+    */
+    bool (*check_sudoku)(const int *cells, check_result *result);
+
+    /*
+        Checks that the row, column and box of a cell hold no duplicates.
+
+        \param cells the cells of the sudoku, all within 0..size^2
+        \param index the index of the cell
+
+        \return false if any of them holds a duplicate
+    */
+    bool (*check_update)(const int *cells, unsigned index);
+} sudoku_kernels;
+
+/*
+    Picks the kernels specialized for a size.
+
+    \param size the size of the sudoku
+
+    \return the kernels of that size, or NULL if there is no specialized instance
+*/
+const sudoku_kernels *get_kernels(unsigned size);
+
+#endif /* end of include guard: SUDOKU_KERNELS_H */
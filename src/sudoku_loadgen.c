@@ -0,0 +1,207 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "sudoku_io.h"
+#include "sudoku_protocol.h"
+#include <stdlib.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+    Settings shared by every connection of a run.
+*/
+typedef struct {
+    const char *path; //< the socket of the server
+    sudoku **puzzles; //< the puzzles to send, in turns
+    unsigned noPuzzles; //< the number of puzzles
+    unsigned requestsPerConnection; //< how many requests every connection sends
+} load_settings;
+
+typedef struct {
+    const load_settings *settings;
+    unsigned id; //< which connection this is, used to spread the puzzles
+    double *latencies; //< the latency of every request, in microseconds
+    unsigned noCompleted; //< the number of requests answered
+} connection_args;
+
+/*
+    Reads the current time from a monotonic clock.
+
+    \return the time in microseconds
+*/
+static double now_us(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec * 1e6 + time.tv_nsec / 1e3;
+}
+
+/*
+    Connection thread body: sends binary requests one after the other, timing each one from the
+    moment it is sent until its answer has been read.
+
+    \param arg a connection_args structure
+*/
+static void *run_connection(void *arg) {
+    connection_args *args = arg;
+    const load_settings *settings = args->settings;
+
+    int fd = connect_to_socket(settings->path);
+    if(fd < 0) {
+        perror(settings->path);
+        return NULL;
+    }
+    FILE *toServer = fdopen(fd, "w");
+    FILE *fromServer = fdopen(dup(fd), "r");
+
+    for(unsigned i = 0; i < settings->requestsPerConnection; ++i) {
+        const sudoku *puzzle = settings->puzzles[(args->id + i) % settings->noPuzzles];
+
+        double start = now_us();
+        write_sudoku_frame(toServer, puzzle);
+        fflush(toServer);
+
+        solve_status status;
+        sudoku *solution;
+        int received = read_result_frame(fromServer, &status, &solution);
+        if(received != 0) {
+            fprintf(stderr, "connection %u: %s\n", args->id,
+                    received > 0 ? "the server rejected a request" : "no answer from the server");
+            break;
+        }
+        args->latencies[args->noCompleted++] = now_us() - start;
+
+        if(solution != NULL) {
+            free_sudoku(solution);
+        }
+    }
+
+    fclose(toServer);
+    fclose(fromServer);
+    return NULL;
+}
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double*) a;
+    double y = *(const double*) b;
+    return (x > y) - (x < y);
+}
+
+/*
+    Finds a percentile of sorted values (nearest rank).
+
+    \param sorted the values, in increasing order
+    \param noValues the number of values
+    \param percent which percentile
+
+    \return the value at that percentile
+*/
+static double percentile(const double *sorted, unsigned noValues, double percent) {
+    unsigned rank = (unsigned) (percent / 100 * noValues + 0.5);
+    if(rank < 1) {
+        rank = 1;
+    }
+    if(rank > noValues) {
+        rank = noValues;
+    }
+    return sorted[rank - 1];
+}
+
+/*
+    Usage: sudoku_loadgen SOCKET PUZZLES [CONNECTIONS] [REQUESTS]
+
+    Loads every puzzle from the file PUZZLES (in the text format) and sends them round robin to
+    the server listening on SOCKET over CONNECTIONS concurrent connections, REQUESTS requests on
+    each. Prints the throughput and the latency percentiles of the run.
+*/
+int main(int argc, char **argv) {
+    if(argc < 3) {
+        fprintf(stderr, "Usage: %s SOCKET PUZZLES [CONNECTIONS] [REQUESTS]\n", argv[0]);
+        return 1;
+    }
+
+    FILE *puzzleFile = fopen(argv[2], "r");
+    if(puzzleFile == NULL) {
+        perror(argv[2]);
+        return 1;
+    }
+
+    unsigned capacity = 16;
+    load_settings settings;
+    settings.path = argv[1];
+    settings.noPuzzles = 0;
+    settings.puzzles = malloc(sizeof(sudoku*) * capacity);
+    assert(settings.puzzles != NULL);
+
+    sudoku *puzzle;
+    while((puzzle = read_sudoku(puzzleFile)) != NULL) {
+        if(settings.noPuzzles == capacity) {
+            capacity *= 2;
+            settings.puzzles = realloc(settings.puzzles, sizeof(sudoku*) * capacity);
+            assert(settings.puzzles != NULL);
+        }
+        settings.puzzles[settings.noPuzzles++] = puzzle;
+    }
+    fclose(puzzleFile);
+
+    if(settings.noPuzzles == 0) {
+        fprintf(stderr, "%s: no puzzles\n", argv[2]);
+        return 1;
+    }
+
+    unsigned noConnections = argc > 3 ? strtoul(argv[3], NULL, 10) : 1;
+    settings.requestsPerConnection = argc > 4 ? strtoul(argv[4], NULL, 10) : 1000;
+    if(noConnections < 1) {
+        noConnections = 1;
+    }
+
+    pthread_t threads[noConnections];
+    connection_args args[noConnections];
+
+    double start = now_us();
+    for(unsigned i = 0; i < noConnections; ++i) {
+        args[i].settings = &settings;
+        args[i].id = i;
+        args[i].noCompleted = 0;
+        args[i].latencies = malloc(sizeof(double) * settings.requestsPerConnection);
+        assert(args[i].latencies != NULL);
+        pthread_create(&threads[i], NULL, run_connection, &args[i]);
+    }
+    for(unsigned i = 0; i < noConnections; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+    double elapsed = now_us() - start;
+
+    // Gather every latency together to compute the percentiles.
+    unsigned noRequests = 0;
+    double *latencies = malloc(sizeof(double) * noConnections * settings.requestsPerConnection + 1);
+    assert(latencies != NULL);
+    for(unsigned i = 0; i < noConnections; ++i) {
+        for(unsigned j = 0; j < args[i].noCompleted; ++j) {
+            latencies[noRequests++] = args[i].latencies[j];
+        }
+        free(args[i].latencies);
+    }
+
+    int status = 0;
+    if(noRequests == 0) {
+        fprintf(stderr, "no request was answered\n");
+        status = 1;
+    }
+    else {
+        qsort(latencies, noRequests, sizeof(double), compare_doubles);
+        printf("requests:     %u\n", noRequests);
+        printf("elapsed:      %.3f s\n", elapsed / 1e6);
+        printf("throughput:   %.1f requests/s\n", noRequests / (elapsed / 1e6));
+        printf("latency p50:  %.1f us\n", percentile(latencies, noRequests, 50));
+        printf("latency p90:  %.1f us\n", percentile(latencies, noRequests, 90));
+        printf("latency p99:  %.1f us\n", percentile(latencies, noRequests, 99));
+        printf("latency max:  %.1f us\n", latencies[noRequests - 1]);
+    }
+
+    free(latencies);
+    for(unsigned i = 0; i < settings.noPuzzles; ++i) {
+        free_sudoku(settings.puzzles[i]);
+    }
+    free(settings.puzzles);
+    return status;
+}
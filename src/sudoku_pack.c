@@ -0,0 +1,89 @@
+#include "sudoku_io.h"
+#include "sudoku_corpus.h"
+#include <stdbool.h>
+#include <string.h>
+#include <inttypes.h>
+
+/*
+    Reads sudokus in the text format from the standard input until it ends and
+    stores them in a new corpus file.
+
+    \param path the corpus file to create
+
+    \return the exit status of the program
+*/
+static int pack(const char *path) {
+    corpus_writer *writer = corpus_create(path);
+    if(writer == NULL) {
+        perror(path);
+        return 1;
+    }
+
+    sudoku *s;
+    read_status status;
+    bool failed = false;
+    while(!failed && (s = read_sudoku_checked(stdin, &status)) != NULL) {
+        failed = corpus_append(writer, s) != 0;
+        free_sudoku(s);
+    }
+
+    if(corpus_finish(writer) != 0 || failed) {
+        perror(path);
+        return 1;
+    }
+    if(status == READ_MALFORMED) {
+        fprintf(stderr, "stopped at a malformed sudoku\n");
+        return 1;
+    }
+    return 0;
+}
+
+/*
+    Writes every sudoku of a corpus file to the standard output in the text
+    format, each one preceded by its size.
+
+    \param path the corpus file to read
+
+    \return the exit status of the program
+*/
+static int unpack(const char *path) {
+    sudoku_corpus *corpus = corpus_open(path);
+    if(corpus == NULL) {
+        fprintf(stderr, "%s: not a sudoku corpus\n", path);
+        return 1;
+    }
+
+    for(uint64_t i = 0; i < corpus->count; ++i) {
+        sudoku *s = corpus_read_sudoku(corpus, i);
+        if(s == NULL) {
+            fprintf(stderr, "%s: sudoku %" PRIu64 " is corrupt\n", path, i);
+            corpus_close(corpus);
+            return 1;
+        }
+        printf("%u\n", s->size);
+        write_sudoku(stdout, s);
+        free_sudoku(s);
+    }
+
+    corpus_close(corpus);
+    return 0;
+}
+
+/*
+    Usage: sudoku_pack pack CORPUS < puzzles
+           sudoku_pack unpack CORPUS > puzzles
+
+    Converts between the text format and the binary corpus format.
+*/
+int main(int argc, char **argv) {
+    if(argc == 3 && strcmp(argv[1], "pack") == 0) {
+        return pack(argv[2]);
+    }
+    if(argc == 3 && strcmp(argv[1], "unpack") == 0) {
+        return unpack(argv[2]);
+    }
+
+    fprintf(stderr, "Usage: %s pack CORPUS < puzzles\n", argv[0]);
+    fprintf(stderr, "       %s unpack CORPUS > puzzles\n", argv[0]);
+    return 1;
+}
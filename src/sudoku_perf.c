@@ -0,0 +1,628 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "sudoku_io.h"
+#include "sudoku_checking.h"
+#include "sudoku_portfolio.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <dirent.h>
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+#include <inttypes.h>
+
+// Default ratio of the baseline time a puzzle may take before it counts as a slowdown.
+static const double DEFAULT_THRESHOLD = 1.5;
+
+// Slowdowns of less than this many milliseconds are put down to noise, whatever the ratio.
+static const double NOISE_MS = 5;
+
+// A puzzle is solved again until this much time has been spent on it (or MAX_RUNS is reached),
+// and the fastest run is kept.
+static const double MIN_TOTAL_MS = 100;
+static const unsigned MAX_RUNS = 5;
+
+// The answer given for a puzzle whose search ran out of time.
+static const char *TIMEOUT_STRING = "TIMEOUT";
+
+// Default number of seconds a search may take before it's cancelled.
+static const double DEFAULT_TIMEOUT = 300;
+
+/*
+    Cancels a search once it runs over its time limit.
+*/
+typedef struct {
+    pthread_mutex_t lock; //< guards `finished`
+    pthread_cond_t finishedChanged;
+    bool finished; //< set once the search is over
+    double seconds; //< the time limit
+    int cancel; //< the cancellation flag given to the search
+} watchdog;
+
+/*
+    The measurements of one puzzle, as stored in a baseline file.
+*/
+typedef struct {
+    char *key; //< the engine and the path of the puzzle, separated by a space
+    double ms; //< the fastest time taken to solve it, in milliseconds
+    unsigned long noNodes; //< the number of search nodes visited
+} perf_entry;
+
+typedef struct {
+    perf_entry *entries;
+    unsigned noEntries;
+    unsigned capacity;
+} perf_baseline;
+
+// The engines that can be measured, by name.
+static const char *const ENGINE_NAMES[NO_ENGINES] = {"dlx", "dlx-descending", "backtracking", "bitset", "9x9"};
+
+/*
+    Adds an entry to a baseline.
+
+    \param baseline the baseline to add to
+    \param key the key of the entry, copied
+    \param ms the time of the entry
+    \param noNodes the node count of the entry
+*/
+static void add_entry(perf_baseline *baseline, const char *key, double ms, unsigned long noNodes) {
+    if(baseline->noEntries == baseline->capacity) {
+        baseline->capacity = baseline->capacity > 0 ? 2 * baseline->capacity : 64;
+        baseline->entries = realloc(baseline->entries, sizeof(perf_entry) * baseline->capacity);
+        assert(baseline->entries != NULL);
+    }
+    char *keyCopy = malloc(strlen(key) + 1);
+    assert(keyCopy != NULL);
+    strcpy(keyCopy, key);
+    baseline->entries[baseline->noEntries++] = (perf_entry){keyCopy, ms, noNodes};
+}
+
+/*
+    Looks up the entry of a puzzle in a baseline.
+
+    \param baseline the baseline to search
+    \param key the engine and path of the puzzle
+
+    \return the entry, or NULL if the puzzle isn't in the baseline
+*/
+static const perf_entry *find_entry(const perf_baseline *baseline, const char *key) {
+    for(unsigned i = 0; i < baseline->noEntries; ++i) {
+        if(strcmp(baseline->entries[i].key, key) == 0) {
+            return &baseline->entries[i];
+        }
+    }
+    return NULL;
+}
+
+/*
+    Sets the measurements of a puzzle in a baseline, replacing its entry if it has one already.
+
+    \param baseline the baseline to change
+    \param key the engine and path of the puzzle
+    \param ms the time of the puzzle
+    \param noNodes the node count of the puzzle
+*/
+static void set_entry(perf_baseline *baseline, const char *key, double ms, unsigned long noNodes) {
+    for(unsigned i = 0; i < baseline->noEntries; ++i) {
+        if(strcmp(baseline->entries[i].key, key) == 0) {
+            baseline->entries[i].ms = ms;
+            baseline->entries[i].noNodes = noNodes;
+            return;
+        }
+    }
+    add_entry(baseline, key, ms, noNodes);
+}
+
+/*
+    Reads a baseline file: one puzzle per line, as the engine, the path, the time in milliseconds
+    and the node count, separated by spaces.
+
+    \param baseline the baseline to fill
+    \param path the file to read
+
+    \return false if the file doesn't exist
+*/
+static bool load_baseline(perf_baseline *baseline, const char *path) {
+    FILE *file = fopen(path, "r");
+    if(file == NULL) {
+        return false;
+    }
+
+    char engine[32];
+    char puzzle[4096];
+    double ms;
+    unsigned long noNodes;
+    while(fscanf(file, "%31s %4095s %lf %lu", engine, puzzle, &ms, &noNodes) == 4) {
+        char key[sizeof(engine) + sizeof(puzzle) + 1];
+        sprintf(key, "%s %s", engine, puzzle);
+        add_entry(baseline, key, ms, noNodes);
+    }
+
+    fclose(file);
+    return true;
+}
+
+/*
+    Writes a baseline file in the format read by load_baseline.
+
+    \param baseline the baseline to save
+    \param path the file to write
+
+    \return 0 on success, -1 on error
+*/
+static int save_baseline(const perf_baseline *baseline, const char *path) {
+    FILE *file = fopen(path, "w");
+    if(file == NULL) {
+        return -1;
+    }
+    for(unsigned i = 0; i < baseline->noEntries; ++i) {
+        const perf_entry *entry = &baseline->entries[i];
+        fprintf(file, "%s %.3f %lu\n", entry->key, entry->ms, entry->noNodes);
+    }
+    return fclose(file) == 0 ? 0 : -1;
+}
+
+static void free_baseline(perf_baseline *baseline) {
+    for(unsigned i = 0; i < baseline->noEntries; ++i) {
+        free(baseline->entries[i].key);
+    }
+    free(baseline->entries);
+}
+
+/*
+    Reads a whole file into memory, dropping trailing whitespace so that outputs can be compared
+    regardless of the final newline.
+
+    \param path the file to read
+
+    \return a new heap-allocated string, or NULL if the file couldn't be read
+*/
+static char *read_trimmed(const char *path) {
+    FILE *file = fopen(path, "r");
+    if(file == NULL) {
+        return NULL;
+    }
+
+    size_t capacity = 4096;
+    size_t length = 0;
+    char *text = malloc(capacity);
+    assert(text != NULL);
+    size_t read;
+    while((read = fread(text + length, 1, capacity - length - 1, file)) > 0) {
+        length += read;
+        if(length + 1 == capacity) {
+            capacity *= 2;
+            text = realloc(text, capacity);
+            assert(text != NULL);
+        }
+    }
+    fclose(file);
+
+    while(length > 0 && (text[length - 1] == ' ' || text[length - 1] == '\n')) {
+        length--;
+    }
+    text[length] = '\0';
+    return text;
+}
+
+/*
+    Watchdog thread: sets the cancellation flag unless the search finishes in time.
+
+    \param args the watchdog
+*/
+static void *watch(void *args) {
+    watchdog *dog = args;
+
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += (time_t) dog->seconds;
+    deadline.tv_nsec += (long) ((dog->seconds - (time_t) dog->seconds) * 1e9);
+    if(deadline.tv_nsec >= 1000000000) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
+    }
+
+    pthread_mutex_lock(&dog->lock);
+    int waited = 0;
+    while(!dog->finished && waited != ETIMEDOUT) {
+        waited = pthread_cond_timedwait(&dog->finishedChanged, &dog->lock, &deadline);
+    }
+    if(!dog->finished) {
+        __atomic_store_n(&dog->cancel, 1, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&dog->lock);
+
+    return NULL;
+}
+
+/*
+    Runs an engine with a time limit.
+
+    \param engine the engine to run
+    \param givenSudoku the puzzle
+    \param seconds the time limit
+    \param noNodes filled in with the number of search nodes visited
+    \param counters where to add the hardware counts of the search, or NULL
+
+    \return the result of the engine, SR_ABORTED if it ran out of time
+*/
+static solve_result solve_with_timeout(solve_engine engine, const sudoku *givenSudoku, double seconds, unsigned long *noNodes,
+                                       solve_counters *counters) {
+    watchdog dog;
+    pthread_mutex_init(&dog.lock, NULL);
+    pthread_cond_init(&dog.finishedChanged, NULL);
+    dog.finished = false;
+    dog.seconds = seconds;
+    dog.cancel = 0;
+
+    pthread_t thread;
+    pthread_create(&thread, NULL, watch, &dog);
+
+    solve_options options = {0, false, &dog.cancel, noNodes, NULL, NULL, counters, false};
+    solve_result result = solve_sudoku_engine(engine, NULL, givenSudoku, &options);
+
+    pthread_mutex_lock(&dog.lock);
+    dog.finished = true;
+    pthread_cond_signal(&dog.finishedChanged);
+    pthread_mutex_unlock(&dog.lock);
+    pthread_join(thread, NULL);
+
+    pthread_cond_destroy(&dog.finishedChanged);
+    pthread_mutex_destroy(&dog.lock);
+    return result;
+}
+
+static double elapsed_ms(const struct timespec *start, const struct timespec *end) {
+    return (end->tv_sec - start->tv_sec) * 1e3 + (end->tv_nsec - start->tv_nsec) / 1e6;
+}
+
+/*
+    Solves a puzzle the way sudoku_solver does, timing the search and writing the answer to a
+    string.
+
+    \param engine the engine to solve with
+    \param givenSudoku the puzzle
+    \param timeout the time limit of a search, in seconds
+    \param ms filled in with the time taken, in milliseconds
+    \param noNodes filled in with the number of search nodes visited
+    \param counters filled in with the hardware counts of the fastest run, or NULL
+
+    \return a new heap-allocated string holding the answer, without trailing whitespace, or
+            TIMEOUT if the search ran out of time
+*/
+static char *solve_and_time(solve_engine engine, const sudoku *givenSudoku, double timeout, double *ms, unsigned long *noNodes,
+                            solve_counters *counters) {
+    char *answer = NULL;
+    size_t length = 0;
+    FILE *output = open_memstream(&answer, &length);
+    assert(output != NULL);
+
+    *ms = 0;
+    *noNodes = 0;
+    solve_counters fastest;
+    if(counters != NULL) {
+        reset_solve_counters(counters);
+        fastest = *counters;
+    }
+
+    switch (check_sudoku(givenSudoku)) {
+        case CR_INVALID:
+            fprintf(output, "%s\n", "UNSOLVABLE");
+            break;
+        case CR_COMPLETE:
+            write_sudoku(output, givenSudoku);
+            break;
+        case CR_INCOMPLETE:
+            ; // Makes the variable initalization below work
+            solve_result result = {SR_ABORTED, NULL};
+            double totalMs = 0;
+            for(unsigned run = 0; run < MAX_RUNS && totalMs < MIN_TOTAL_MS; ++run) {
+                if(result.solution != NULL) {
+                    free_sudoku(result.solution);
+                }
+
+                if(counters != NULL) {
+                    reset_solve_counters(counters);
+                }
+                struct timespec start, end;
+                clock_gettime(CLOCK_MONOTONIC, &start);
+                result = solve_with_timeout(engine, givenSudoku, timeout, noNodes, counters);
+                clock_gettime(CLOCK_MONOTONIC, &end);
+
+                double runMs = elapsed_ms(&start, &end);
+                totalMs += runMs;
+                if(run == 0 || runMs < *ms) {
+                    *ms = runMs;
+                    if(counters != NULL) {
+                        fastest = *counters;
+                    }
+                }
+                if(result.status == SR_ABORTED) {
+                    break;
+                }
+            }
+
+            switch (result.status) {
+                case SR_UNSOLVABLE:
+                    fprintf(output, "%s\n", "UNSOLVABLE");
+                    break;
+                case SR_MULTIPLE:
+                    fprintf(output, "%s\n", "MULTIPLE");
+                    break;
+                case SR_SOLVED:
+                    write_sudoku(output, result.solution);
+                    break;
+                case SR_ABORTED:
+                    fprintf(output, "%s\n", TIMEOUT_STRING);
+                    break;
+                case SR_NO_MEMORY:
+                    fprintf(output, "%s\n", "OUT_OF_MEMORY");
+                    break;
+            }
+            if(result.solution != NULL) {
+                free_sudoku(result.solution);
+            }
+            break;
+    }
+
+    if(counters != NULL) {
+        *counters = fastest;
+    }
+
+    fclose(output);
+    while(length > 0 && (answer[length - 1] == ' ' || answer[length - 1] == '\n')) {
+        length--;
+    }
+    answer[length] = '\0';
+    return answer;
+}
+
+/*
+    Writes the hardware counts of a phase of a search, in total and per search node.
+
+    \param phase the name of the phase
+    \param counters the counters, telling which ones are available
+    \param counts the counts of the phase
+    \param noNodes the number of search nodes visited
+*/
+static void write_counts(const char *phase, const solve_counters *counters, const uint64_t counts[NO_HARDWARE_COUNTERS],
+                         unsigned long noNodes) {
+    printf("    %-6s", phase);
+    for(unsigned i = 0; i < NO_HARDWARE_COUNTERS; ++i) {
+        if(counters->fds[i] >= 0) {
+            printf(" %s %" PRIu64, hardware_counter_name((hardware_counter) i), counts[i]);
+        }
+    }
+    if(noNodes > 0) {
+        printf("  per node:");
+        for(unsigned i = 0; i < NO_HARDWARE_COUNTERS; ++i) {
+            if(counters->fds[i] >= 0) {
+                printf(" %.2f", (double) counts[i] / noNodes);
+            }
+        }
+    }
+    printf("\n");
+}
+
+static int compare_names(const void *a, const void *b) {
+    return strcmp(*(char *const *) a, *(char *const *) b);
+}
+
+/*
+    Lists the puzzles (.in files) of a directory, sorted by name.
+
+    \param directory the directory to list
+    \param noPuzzles filled in with the number of puzzles found
+
+    \return a new heap-allocated array of heap-allocated paths, or NULL if the directory couldn't
+            be opened
+*/
+static char **list_puzzles(const char *directory, unsigned *noPuzzles) {
+    DIR *dir = opendir(directory);
+    if(dir == NULL) {
+        return NULL;
+    }
+
+    unsigned capacity = 64;
+    char **paths = malloc(sizeof(char*) * capacity);
+    assert(paths != NULL);
+    *noPuzzles = 0;
+
+    struct dirent *entry;
+    while((entry = readdir(dir)) != NULL) {
+        size_t nameLength = strlen(entry->d_name);
+        if(nameLength > 3 && strcmp(entry->d_name + nameLength - 3, ".in") == 0) {
+            if(*noPuzzles == capacity) {
+                capacity *= 2;
+                paths = realloc(paths, sizeof(char*) * capacity);
+                assert(paths != NULL);
+            }
+            char *path = malloc(strlen(directory) + nameLength + 2);
+            assert(path != NULL);
+            sprintf(path, "%s/%s", directory, entry->d_name);
+            paths[(*noPuzzles)++] = path;
+        }
+    }
+    closedir(dir);
+
+    qsort(paths, *noPuzzles, sizeof(char*), compare_names);
+    return paths;
+}
+
+/*
+    Usage: sudoku_perf [--threshold RATIO] [--timeout SECONDS] [--update] [--counters] BASELINE ENGINE DIR [ENGINE DIR]...
+
+    Solves every puzzle (.in file) of every DIR with the given ENGINE (dlx, dlx-descending,
+    backtracking, bitset or 9x9), checks the answer against the matching .out file, and measures
+    the time (fastest of a few runs) and search nodes every puzzle takes.
+
+    The measurements are compared to the ones stored in the BASELINE file. A puzzle taking more than
+    RATIO (1.5 by default) times its baseline time is reported as a slowdown, and a search taking
+    over SECONDS (300 by default) is cancelled and reported as a timeout, and a search visiting
+    more nodes than in the baseline is reported too. A wrong answer, a slowdown, more nodes or a
+    timeout (unless the baseline timed out too) makes the run fail. If the baseline doesn't exist
+    yet, or with --update, the measurements are written to it instead, replacing the ones of the
+    same puzzles and keeping the others; a timeout is then recorded rather than failing the run.
+
+    With --counters, the hardware counts of building the table and of searching it (dancing links
+    only, see sudoku_counters.h) are written under every puzzle, also divided by its search nodes.
+*/
+int main(int argc, char **argv) {
+    double threshold = DEFAULT_THRESHOLD;
+    double timeout = DEFAULT_TIMEOUT;
+    bool update = false;
+    bool countHardware = false;
+
+    int arg = 1;
+    for(; arg < argc && strncmp(argv[arg], "--", 2) == 0; ++arg) {
+        if(strcmp(argv[arg], "--threshold") == 0 && arg + 1 < argc) {
+            threshold = strtod(argv[++arg], NULL);
+        }
+        else if(strcmp(argv[arg], "--timeout") == 0 && arg + 1 < argc) {
+            timeout = strtod(argv[++arg], NULL);
+        }
+        else if(strcmp(argv[arg], "--update") == 0) {
+            update = true;
+        }
+        else if(strcmp(argv[arg], "--counters") == 0) {
+            countHardware = true;
+        }
+        else {
+            break;
+        }
+    }
+    if(arg == argc || (argc - arg) % 2 != 1 || threshold <= 0 || timeout <= 0) {
+        fprintf(stderr, "Usage: %s [--threshold RATIO] [--timeout SECONDS] [--update] [--counters] BASELINE ENGINE DIR [ENGINE DIR]...\n", argv[0]);
+        return 1;
+    }
+
+    solve_counters counters;
+    if(countHardware && !open_solve_counters(&counters)) {
+        fprintf(stderr, "hardware counters unavailable, only measuring time\n");
+        countHardware = false;
+    }
+    const char *baselinePath = argv[arg++];
+
+    perf_baseline baseline = {NULL, 0, 0};
+    if(!load_baseline(&baseline, baselinePath)) {
+        update = true;
+    }
+    perf_baseline measured = {NULL, 0, 0};
+
+    unsigned noWrong = 0;
+    unsigned noSlower = 0;
+    unsigned noMoreNodes = 0;
+    unsigned noTimeouts = 0;
+    for(; arg < argc; arg += 2) {
+        const char *engineName = argv[arg];
+        const char *directory = argv[arg + 1];
+
+        int engine = 0;
+        while(engine < NO_ENGINES && strcmp(ENGINE_NAMES[engine], engineName) != 0) {
+            engine++;
+        }
+        if(engine == NO_ENGINES) {
+            fprintf(stderr, "%s: unknown engine\n", engineName);
+            return 1;
+        }
+
+        unsigned noPuzzles;
+        char **puzzles = list_puzzles(directory, &noPuzzles);
+        if(puzzles == NULL) {
+            perror(directory);
+            return 1;
+        }
+
+        for(unsigned i = 0; i < noPuzzles; ++i) {
+            const char *path = puzzles[i];
+            char key[strlen(engineName) + strlen(path) + 2];
+            sprintf(key, "%s %s", engineName, path);
+
+            char expectedPath[strlen(path) + 2];
+            strcpy(expectedPath, path);
+            strcpy(expectedPath + strlen(path) - 3, ".out");
+            char *expected = read_trimmed(expectedPath);
+
+            FILE *input = fopen(path, "r");
+            sudoku *givenSudoku = input != NULL ? read_sudoku(input) : NULL;
+            if(input != NULL) {
+                fclose(input);
+            }
+
+            double ms = 0;
+            unsigned long noNodes = 0;
+            bool correct = false;
+            bool timedOut = false;
+            bool readable = givenSudoku != NULL;
+            if(readable) {
+                char *answer = solve_and_time(engine, givenSudoku, timeout, &ms, &noNodes, countHardware ? &counters : NULL);
+                timedOut = strcmp(answer, TIMEOUT_STRING) == 0;
+                correct = expected != NULL && strcmp(answer, expected) == 0;
+                free(answer);
+                free_sudoku(givenSudoku);
+            }
+            free(expected);
+            add_entry(&measured, key, ms, noNodes);
+
+            printf("%s %s %10.3f ms %12lu nodes", engineName, path, ms, noNodes);
+            const perf_entry *before = find_entry(&baseline, key);
+            if(timedOut) {
+                // A search that timed out in the baseline as well has nothing to compare against.
+                bool alreadyTimedOut = before != NULL && !update && before->ms >= timeout * 1e3;
+                printf("  %s%s", TIMEOUT_STRING, alreadyTimedOut ? " (as in the baseline)" : "");
+                // When writing the baseline, a timeout is recorded for later runs to compare against.
+                noTimeouts += alreadyTimedOut || update ? 0 : 1;
+            }
+            else if(!correct) {
+                printf("  WRONG");
+                noWrong++;
+            }
+            else if(before != NULL && !update) {
+                printf("  (baseline %.3f ms, %lu nodes)", before->ms, before->noNodes);
+                if(ms > before->ms * threshold && ms - before->ms > NOISE_MS) {
+                    printf("  SLOWER");
+                    noSlower++;
+                }
+                // The engines are deterministic, so any extra node is a change to the search itself.
+                if(noNodes > before->noNodes) {
+                    printf("  MORE NODES");
+                    noMoreNodes++;
+                }
+            }
+            printf("\n");
+            if(countHardware && readable) {
+                write_counts("table", &counters, counters.table, noNodes);
+                write_counts("search", &counters, counters.search, noNodes);
+            }
+            fflush(stdout);
+
+            free(puzzles[i]);
+        }
+        free(puzzles);
+    }
+
+    printf("%u puzzles, %u wrong, %u slower than %.2fx the baseline, %u with more nodes, %u timed out\n",
+           measured.noEntries, noWrong, noSlower, threshold, noMoreNodes, noTimeouts);
+
+    int status = noWrong == 0 && noSlower == 0 && noMoreNodes == 0 && noTimeouts == 0 ? 0 : 1;
+    if(update) {
+        for(unsigned i = 0; i < measured.noEntries; ++i) {
+            set_entry(&baseline, measured.entries[i].key, measured.entries[i].ms, measured.entries[i].noNodes);
+        }
+        if(save_baseline(&baseline, baselinePath) != 0) {
+            perror(baselinePath);
+            status = 1;
+        }
+        else {
+            printf("baseline written to %s\n", baselinePath);
+        }
+    }
+
+    if(countHardware) {
+        close_solve_counters(&counters);
+    }
+    free_baseline(&baseline);
+    free_baseline(&measured);
+    return status;
+}
@@ -0,0 +1,300 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "sudoku_pipeline.h"
+#include "sudoku_trace.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+/*
+    A sudoku somewhere between being read and having its result written.
+*/
+typedef struct {
+    sudoku *puzzle; //< the sudoku, until a worker is done with it, or NULL if it was malformed
+    char *result; //< the result written by the worker, once it's done
+    size_t length; //< the length of the result
+    unsigned long cost; //< the estimated cost of the sudoku, once estimated
+    bool done; //< if the result is ready to be written
+} pipeline_slot;
+
+/*
+    Shared state of the pipeline. Sudoku number i lives in slots[i % window] from the moment it's
+    read until its result is written.
+*/
+typedef struct {
+    FILE *input;
+    FILE *output;
+    pipeline_reader read;
+    pipeline_worker process;
+    void *context;
+    pipeline_estimator estimate;
+
+    pipeline_slot *slots;
+    unsigned window;
+    unsigned long *ready; //< the numbers of the sudokus ready to be taken, a heap with the one to
+                          //  take next on top
+    unsigned noReady;
+
+    unsigned long noRead; //< the number of sudokus read so far
+    unsigned long noEstimated; //< the number of sudokus a worker started estimating, in input order
+    unsigned long noTaken; //< the number of sudokus taken by a worker so far
+    unsigned long noWritten; //< the number of results written so far
+    bool endOfInput; //< set once the reader is done
+
+    pthread_mutex_t lock; //< guards all the counters and slots
+    pthread_cond_t slotFreed; //< the reader can go on
+    pthread_cond_t puzzleRead; //< a worker can estimate or take a sudoku, or the input ended
+    pthread_cond_t resultReady; //< the writer can go on, or the input ended
+} pipeline;
+
+/*
+    If sudoku a should be taken before sudoku b: the one with the larger cost, or the one read
+    first if they cost the same.
+*/
+static bool takes_before(const pipeline *p, unsigned long a, unsigned long b) {
+    const unsigned long costA = p->slots[a % p->window].cost;
+    const unsigned long costB = p->slots[b % p->window].cost;
+    return costA > costB || (costA == costB && a < b);
+}
+
+/*
+    Makes a sudoku ready to be taken.
+
+    \param p the shared pipeline, locked
+    \param number the number of the sudoku
+*/
+static void push_ready(pipeline *p, unsigned long number) {
+    unsigned i = p->noReady++;
+    while(i > 0 && takes_before(p, number, p->ready[(i - 1) / 2])) {
+        p->ready[i] = p->ready[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    p->ready[i] = number;
+}
+
+/*
+    Takes the sudoku to process next out of the ready ones.
+
+    \param p the shared pipeline, locked, with a ready sudoku
+*/
+static unsigned long pop_ready(pipeline *p) {
+    const unsigned long top = p->ready[0];
+    const unsigned long last = p->ready[--p->noReady];
+    unsigned i = 0;
+    while(2 * i + 1 < p->noReady) {
+        unsigned child = 2 * i + 1;
+        if(child + 1 < p->noReady && takes_before(p, p->ready[child + 1], p->ready[child])) {
+            child++;
+        }
+        if(!takes_before(p, p->ready[child], last)) {
+            break;
+        }
+        p->ready[i] = p->ready[child];
+        i = child;
+    }
+    p->ready[i] = last;
+    return top;
+}
+
+/*
+    Parser thread: reads sudokus into the window until the input ends.
+
+    \param args the shared pipeline
+*/
+static void *read_stage(void *args) {
+    pipeline *p = args;
+
+    while(true) {
+        pthread_mutex_lock(&p->lock);
+        while(p->noRead - p->noWritten == p->window) {
+            pthread_cond_wait(&p->slotFreed, &p->lock);
+        }
+        pthread_mutex_unlock(&p->lock);
+
+        // Only this thread reads, so the stream needs no lock.
+        TRACE_PUZZLE(p->noRead + 1);
+        read_status status;
+        sudoku *puzzle = p->read(p->input, &status);
+
+        pthread_mutex_lock(&p->lock);
+        if(puzzle == NULL && status == READ_END) {
+            p->endOfInput = true;
+            pthread_cond_broadcast(&p->puzzleRead);
+            pthread_cond_signal(&p->resultReady);
+            pthread_mutex_unlock(&p->lock);
+            break;
+        }
+        p->slots[p->noRead % p->window] = (pipeline_slot){puzzle, NULL, 0, 0, false};
+        if(p->estimate == NULL) {
+            push_ready(p, p->noRead);
+        }
+        p->noRead++;
+        pthread_cond_signal(&p->puzzleRead);
+        pthread_mutex_unlock(&p->lock);
+    }
+
+    return NULL;
+}
+
+/*
+    Worker thread: estimates the sudokus in input order, if there's an estimator, takes them
+    hardest first and writes their results to memory. Estimating comes before taking, so that the
+    hardest sudoku is picked out of as many as possible.
+
+    \param args the shared pipeline
+*/
+static void *solve_stage(void *args) {
+    pipeline *p = args;
+
+    while(true) {
+        pthread_mutex_lock(&p->lock);
+        bool toEstimate = p->estimate != NULL && p->noEstimated < p->noRead;
+        while(!toEstimate && p->noReady == 0 && !(p->endOfInput && p->noTaken == p->noRead)) {
+            pthread_cond_wait(&p->puzzleRead, &p->lock);
+            toEstimate = p->estimate != NULL && p->noEstimated < p->noRead;
+        }
+        if(toEstimate) {
+            // Nothing else touches a sudoku before it's estimated, so it's estimated unlocked.
+            unsigned long number = p->noEstimated++;
+            pipeline_slot *slot = &p->slots[number % p->window];
+            pthread_mutex_unlock(&p->lock);
+
+            TRACE_PUZZLE(number + 1);
+            TRACE_BEGIN("estimate_hardness");
+            unsigned long cost = slot->puzzle != NULL ? p->estimate(slot->puzzle) : 0;
+            TRACE_END("estimate_hardness");
+
+            pthread_mutex_lock(&p->lock);
+            slot->cost = cost;
+            push_ready(p, number);
+            pthread_cond_signal(&p->puzzleRead);
+            pthread_mutex_unlock(&p->lock);
+            continue;
+        }
+        if(p->noReady == 0) {
+            pthread_mutex_unlock(&p->lock);
+            break;
+        }
+        unsigned long number = pop_ready(p);
+        p->noTaken++;
+        if(p->endOfInput && p->noTaken == p->noRead) {
+            // The other workers waiting have nothing left to do.
+            pthread_cond_broadcast(&p->puzzleRead);
+        }
+        pipeline_slot *slot = &p->slots[number % p->window];
+        sudoku *puzzle = slot->puzzle;
+        pthread_mutex_unlock(&p->lock);
+
+        char *result = NULL;
+        size_t length = 0;
+        FILE *output = open_memstream(&result, &length);
+        assert(output != NULL);
+        TRACE_PUZZLE(number + 1);
+        p->process(puzzle, output, p->context);
+        fclose(output);
+        if(puzzle != NULL) {
+            free_sudoku(puzzle);
+        }
+
+        pthread_mutex_lock(&p->lock);
+        slot->puzzle = NULL;
+        slot->result = result;
+        slot->length = length;
+        slot->done = true;
+        if(number == p->noWritten) {
+            pthread_cond_signal(&p->resultReady);
+        }
+        pthread_mutex_unlock(&p->lock);
+    }
+
+    return NULL;
+}
+
+/*
+    Writer thread: writes the results in input order, holding back the ones that finished early.
+
+    \param args the shared pipeline
+*/
+static void *write_stage(void *args) {
+    pipeline *p = args;
+
+    while(true) {
+        pthread_mutex_lock(&p->lock);
+        pipeline_slot *slot = &p->slots[p->noWritten % p->window];
+        while(!(p->noWritten < p->noRead && slot->done) && !(p->endOfInput && p->noWritten == p->noRead)) {
+            pthread_cond_wait(&p->resultReady, &p->lock);
+        }
+        if(p->noWritten == p->noRead) {
+            pthread_mutex_unlock(&p->lock);
+            break;
+        }
+        char *result = slot->result;
+        size_t length = slot->length;
+        pthread_mutex_unlock(&p->lock);
+
+        TRACE_PUZZLE(p->noWritten + 1);
+        TRACE_BEGIN("write_result");
+        fwrite(result, 1, length, p->output);
+        TRACE_END("write_result");
+        free(result);
+
+        pthread_mutex_lock(&p->lock);
+        slot->result = NULL;
+        slot->done = false;
+        p->noWritten++;
+        pthread_cond_signal(&p->slotFreed);
+        pthread_mutex_unlock(&p->lock);
+    }
+
+    return NULL;
+}
+
+unsigned long run_pipeline(FILE *input, FILE *output, pipeline_reader read, pipeline_worker process,
+                           void *context, pipeline_estimator estimate, unsigned noWorkers, unsigned window) {
+    assert(noWorkers > 0);
+    assert(window > 0);
+
+    pipeline p;
+    p.input = input;
+    p.output = output;
+    p.read = read;
+    p.process = process;
+    p.context = context;
+    p.estimate = estimate;
+    p.window = window;
+    p.slots = calloc(window, sizeof(pipeline_slot));
+    p.ready = malloc(sizeof(unsigned long) * window);
+    assert(p.slots != NULL && p.ready != NULL);
+    p.noReady = 0;
+    p.noRead = p.noEstimated = p.noTaken = p.noWritten = 0;
+    p.endOfInput = false;
+    pthread_mutex_init(&p.lock, NULL);
+    pthread_cond_init(&p.slotFreed, NULL);
+    pthread_cond_init(&p.puzzleRead, NULL);
+    pthread_cond_init(&p.resultReady, NULL);
+
+    pthread_t reader;
+    pthread_t writer;
+    pthread_t workers[noWorkers];
+    pthread_create(&reader, NULL, read_stage, &p);
+    for(unsigned i = 0; i < noWorkers; ++i) {
+        pthread_create(&workers[i], NULL, solve_stage, &p);
+    }
+    pthread_create(&writer, NULL, write_stage, &p);
+
+    pthread_join(reader, NULL);
+    for(unsigned i = 0; i < noWorkers; ++i) {
+        pthread_join(workers[i], NULL);
+    }
+    pthread_join(writer, NULL);
+
+    pthread_cond_destroy(&p.resultReady);
+    pthread_cond_destroy(&p.puzzleRead);
+    pthread_cond_destroy(&p.slotFreed);
+    pthread_mutex_destroy(&p.lock);
+    free(p.ready);
+    free(p.slots);
+
+    return p.noWritten;
+}
@@ -0,0 +1,73 @@
+/*
+    \file sudoku_pipeline.h
+    \brief A three stage read, solve and write pipeline for batches of sudokus
+
+    A parser thread reads sudokus into a bounded window, a pool of workers processes them, and a
+    writer thread emits their results in input order, so reading and writing overlap with solving.
+    Every result is written to memory by its worker first, which lets the writer reorder them.
+
+    The workers can take the sudokus of the window hardest first, by an estimate of their cost,
+    instead of in input order. A hard sudoku taken last keeps the whole batch waiting on a single
+    worker, while taken first, the easy ones are spread over the other workers meanwhile.
+*/
+
+#ifndef SUDOKU_PIPELINE_H
+#define SUDOKU_PIPELINE_H
+
+#include "sudoku.h"
+#include "sudoku_io.h"
+#include <stdio.h>
+
+/*
+    Reads the next sudoku of a batch, like read_sudoku_checked or read_sudoku_line_checked.
+
+    \param input the stream to read from
+    \param status set to why no sudoku was read, if none was
+
+    \return a new heap-allocated sudoku, or NULL at the end of the batch or for a malformed one
+*/
+typedef sudoku *(*pipeline_reader)(FILE *input, read_status *status);
+
+/*
+    Processes one sudoku of a batch. Called from several worker threads at once.
+
+    \param s the sudoku to process, or NULL for a malformed one, which still gets a result in
+             its place
+    \param output where to write the result of this sudoku
+    \param context the context given to run_pipeline
+*/
+typedef void (*pipeline_worker)(const sudoku *s, FILE *output, void *context);
+
+/*
+    Estimates how long a sudoku of a batch takes to process, like estimate_hardness. Called from
+    several worker threads at once.
+
+    \param s the sudoku to estimate
+
+    \return the estimate, larger for sudokus expected to take longer
+*/
+typedef unsigned long (*pipeline_estimator)(const sudoku *s);
+
+/*
+    Reads every sudoku of a stream, processes them on a pool of threads and writes their results
+    in the order the sudokus were read.
+
+    \param input the stream to read the sudokus from
+    \param output the stream to write the results to
+    \param read how to read a sudoku
+    \param process how to process a sudoku
+    \param context passed on to every call of process
+    \param estimate how to estimate a sudoku, for the workers to take the sudokus of the window
+                    with the largest estimate first (the earliest read among equal ones), or NULL
+                    to take them in input order
+    \param noWorkers the number of worker threads
+    \param window the largest number of sudokus read but not written yet, which bounds the memory
+                  used, how far reading can run ahead of writing and how far ahead of input order
+                  a hard sudoku can be taken
+
+    \return the number of sudokus processed
+*/
+unsigned long run_pipeline(FILE *input, FILE *output, pipeline_reader read, pipeline_worker process,
+                           void *context, pipeline_estimator estimate, unsigned noWorkers, unsigned window);
+
+#endif /* end of include guard: SUDOKU_PIPELINE_H */
@@ -0,0 +1,172 @@
+#include "sudoku_portfolio.h"
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+// The engines raced when none are given.
+static const solve_engine ALL_ENGINES[NO_ENGINES] = {ENGINE_DLX, ENGINE_DLX_DESCENDING, ENGINE_BACKTRACKING, ENGINE_BITSET, ENGINE_9X9};
+
+// No engine has won the race yet.
+#define NO_WINNER -1
+
+/*
+    Shared state of a race.
+*/
+typedef struct {
+    const sudoku *input; //< the sudoku every engine solves
+    int winner; //< the index of the first engine to reach a verdict, or NO_WINNER
+    int cancel; //< set once there is a winner, the other engines poll it
+} portfolio_race;
+
+typedef struct {
+    portfolio_race *race;
+    solve_engine engine;
+    int index; //< the position of the engine in the race
+    solve_result result;
+} portfolio_entry;
+
+solve_result solve_sudoku_engine(solve_engine engine, const sudoku_allocator *allocator, const sudoku *input,
+                                 const solve_options *options) {
+    solve_options engineOptions = *options;
+    switch(engine) {
+        case ENGINE_DLX:
+            engineOptions.descending = false;
+            return solve_sudoku_dlx(allocator, input, &engineOptions);
+        case ENGINE_DLX_DESCENDING:
+            engineOptions.descending = true;
+            return solve_sudoku_dlx(allocator, input, &engineOptions);
+        case ENGINE_BACKTRACKING:
+            return solve_sudoku_backtracking(allocator, input, &engineOptions);
+        case ENGINE_BITSET:
+            engineOptions.descending = false;
+            return solve_sudoku_bitset(allocator, input, &engineOptions);
+        case ENGINE_9X9:
+            engineOptions.descending = false;
+            return solve_sudoku_9x9(allocator, input, &engineOptions);
+    }
+
+    assert(false);
+    return (solve_result){SR_ABORTED, NULL};
+}
+
+/*
+    Worker thread: runs one engine until it reaches a verdict or another engine wins.
+
+    \param args the portfolio_entry of the engine
+*/
+static void *portfolio_worker(void *args) {
+    portfolio_entry *entry = args;
+    portfolio_race *race = entry->race;
+
+    solve_options options = {0, false, &race->cancel, NULL, NULL, NULL, NULL, false};
+    entry->result = solve_sudoku_engine(entry->engine, NULL, race->input, &options);
+
+    if(entry->result.status != SR_ABORTED) {
+        int noWinner = NO_WINNER;
+        if(__atomic_compare_exchange_n(&race->winner, &noWinner, entry->index, false,
+                                       __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            __atomic_store_n(&race->cancel, 1, __ATOMIC_RELAXED);
+        }
+    }
+
+    return NULL;
+}
+
+/*
+    One of the two searches of solve_sudoku_dual.
+*/
+typedef struct {
+    const sudoku *input;
+    solve_options options;
+    unsigned long noNodes;
+    solve_result result;
+} dual_search;
+
+/*
+    Runs one of the two searches of solve_sudoku_dual, possibly as a thread.
+
+    \param args the dual_search to run
+*/
+static void *dual_worker(void *args) {
+    dual_search *search = args;
+    search->options.noNodes = &search->noNodes;
+    search->result = search->input->size == 3 ? solve_sudoku_9x9(NULL, search->input, &search->options)
+                   : solve_sudoku_bitset(NULL, search->input, &search->options);
+    return NULL;
+}
+
+solve_result solve_sudoku_dual(const sudoku *input, const solve_options *options, bool threaded) {
+    const solve_options first = {options->maxNodes, false, options->cancel, NULL, NULL, NULL, NULL, true};
+    dual_search searches[2] = {{input, first, 0, {SR_ABORTED, NULL}}, {input, first, 0, {SR_ABORTED, NULL}}};
+    searches[1].options.descending = true;
+
+    if(threaded) {
+        // Without a solution, both searches go through the whole tree, so neither can cut the
+        // other short.
+        pthread_t thread;
+        pthread_create(&thread, NULL, dual_worker, &searches[1]);
+        dual_worker(&searches[0]);
+        pthread_join(thread, NULL);
+    }
+    else {
+        dual_worker(&searches[0]);
+        // A search that found nothing went through the whole tree or ran out of nodes, and the
+        // other one would do the same.
+        if(searches[0].result.solution != NULL) {
+            dual_worker(&searches[1]);
+        }
+    }
+
+    if(options->noNodes != NULL) {
+        *options->noNodes = searches[0].noNodes + searches[1].noNodes;
+    }
+
+    const sudoku *ascending = searches[0].result.solution;
+    sudoku *descending = searches[1].result.solution;
+    solve_result result = {searches[0].result.status, searches[0].result.solution};
+    if(ascending != NULL && descending != NULL) {
+        result.status = memcmp(ascending->cells, descending->cells, sizeof(int) * get_no_cells(input)) == 0
+                      ? SR_SOLVED : SR_MULTIPLE;
+    }
+    if(descending != NULL) {
+        if(result.solution == NULL) {
+            result.solution = descending;
+        }
+        else {
+            free_sudoku(descending);
+        }
+    }
+    return result;
+}
+
+solve_result solve_sudoku_portfolio(const sudoku *input, const solve_engine *engines, unsigned noEngines) {
+    if(engines == NULL) {
+        engines = ALL_ENGINES;
+        // The bitset and 9x9 engines come last, so they can be left out.
+        noEngines = input->size == 3 ? NO_ENGINES : input->size <= BITSET_MAX_SIZE ? NO_ENGINES - 1 : NO_ENGINES - 2;
+    }
+    assert(noEngines > 0);
+
+    portfolio_race race = {input, NO_WINNER, 0};
+    portfolio_entry entries[noEngines];
+    pthread_t threads[noEngines];
+
+    for(unsigned i = 0; i < noEngines; ++i) {
+        entries[i] = (portfolio_entry){&race, engines[i], (int) i, {SR_ABORTED, NULL}};
+        pthread_create(&threads[i], NULL, portfolio_worker, &entries[i]);
+    }
+    for(unsigned i = 0; i < noEngines; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+
+    // Every engine searches until cancelled, so someone must have reached a verdict.
+    assert(race.winner != NO_WINNER);
+
+    for(unsigned i = 0; i < noEngines; ++i) {
+        if((int) i != race.winner && entries[i].result.solution != NULL) {
+            free_sudoku(entries[i].result.solution);
+        }
+    }
+
+    return entries[race.winner].result;
+}
@@ -0,0 +1,169 @@
+/*
+    \file sudoku_portfolio.h
+    \brief The solving engines under their own names, and a portfolio racing them against each other
+
+    solve_sudoku is provided by whichever engine a program is linked with. The engines are also
+    built as objects (with SUDOKU_ENGINE_ONLY defined) that only provide the functions declared
+    here, so a program can hold both and pick between them at run time.
+
+    Hard instances differ a lot in which engine suits them, so solve_sudoku_portfolio runs several
+    engines on the same sudoku in parallel threads: the first one to reach a verdict wins, and the
+    others are cancelled.
+*/
+
+#ifndef SUDOKU_PORTFOLIO_H
+#define SUDOKU_PORTFOLIO_H
+
+#include "sudoku.h"
+#include "sudoku_solve.h"
+#include "sudoku_progress.h"
+#include "sudoku_checkpoint.h"
+#include "sudoku_counters.h"
+#include <stdbool.h>
+
+/*
+    Settings of a single search.
+*/
+typedef struct {
+    unsigned long maxNodes; //< the node budget of the search, or 0 for an unbounded search
+    bool descending; //< try the values of a cell from the largest down (dancing links only)
+    const int *cancel; //< the search gives up (SR_ABORTED) once this becomes non-zero, or NULL
+    unsigned long *noNodes; //< filled in with the number of search nodes visited, or NULL
+    solve_progress *progress; //< where to publish the progress of the search, or NULL (dancing links only)
+    solve_checkpoint *checkpoint; //< where to save the position of the search and where to resume it
+                                  //  from, or NULL (dancing links only, resumed with the same options)
+    solve_counters *counters; //< where to add the hardware counts of building the table and of the
+                              //  search, or NULL (dancing links only)
+    bool firstSolution; //< stop at the first solution, which is returned as SR_ABORTED, instead of
+                        //  looking for a second one (not for backtracking)
+} solve_options;
+
+/*
+    The engines and heuristics a portfolio can race.
+*/
+typedef enum {
+    ENGINE_DLX,             //< dancing links, values tried in ascending order
+    ENGINE_DLX_DESCENDING,  //< dancing links, values tried in descending order
+    ENGINE_BACKTRACKING,    //< cell by cell backtracking
+    ENGINE_BITSET,          //< Algorithm X on bitsets, values tried in ascending order
+    ENGINE_9X9              //< candidate masks and singles for 9x9 sudokus, values tried in ascending order
+} solve_engine;
+
+// The number of values of solve_engine.
+#define NO_ENGINES 5
+
+// The largest sudokus the bitset engine solves itself: every column of their matrix fits in 32 bits.
+#define BITSET_MAX_SIZE 5
+
+/*
+    Solves a sudoku with dancing links (see sudoku_solve_advanced.c).
+
+    \param allocator where to allocate the working memory and the solution, or NULL for malloc
+    \param input the sudoku to be solved
+    \param options the settings of the search
+
+    \return the same as solve_sudoku_with
+*/
+solve_result solve_sudoku_dlx(const sudoku_allocator *allocator, const sudoku *input, const solve_options *options);
+
+/*
+    Solves a sudoku with backtracking (see sudoku_solve.c). The descending, progress,
+    checkpoint, counters and firstSolution options are ignored.
+
+    \param allocator where to allocate the working memory and the solution, or NULL for malloc
+    \param input the sudoku to be solved
+    \param options the settings of the search
+
+    \return the same as solve_sudoku_with
+*/
+solve_result solve_sudoku_backtracking(const sudoku_allocator *allocator, const sudoku *input, const solve_options *options);
+
+/*
+    Solves a sudoku with Algorithm X on bitsets (see sudoku_solve_bitset.c), handing sudokus larger
+    than BITSET_MAX_SIZE to dancing links. The progress, checkpoint and counters options are
+    ignored.
+
+    \param allocator where to allocate the working memory and the solution, or NULL for malloc
+    \param input the sudoku to be solved
+    \param options the settings of the search
+
+    \return the same as solve_sudoku_with
+*/
+solve_result solve_sudoku_bitset(const sudoku_allocator *allocator, const sudoku *input, const solve_options *options);
+
+/*
+    Solves a sudoku with the engine specialized for 9x9 sudokus (see sudoku_solve_9x9.c), handing
+    sudokus of any other size to dancing links. A search node is a guess rather than a placed
+    value, so the same budget goes further than with the other engines. The progress, checkpoint
+    and counters options are ignored.
+
+    \param allocator where to allocate the solution, or NULL for malloc
+    \param input the sudoku to be solved
+    \param options the settings of the search
+
+    \return the same as solve_sudoku_with
+*/
+solve_result solve_sudoku_9x9(const sudoku_allocator *allocator, const sudoku *input, const solve_options *options);
+
+/*
+    Solves a 9x9 sudoku like solve_sudoku_9x9, writing the solution into a sudoku owned by the
+    caller. Makes no allocations at all: the whole search lives on the stack.
+
+    \param input the sudoku to be solved, of size 3
+    \param solution where to write the solution, if one is found: a sudoku of size 3
+    \param options the settings of the search
+
+    \return the status solve_sudoku_9x9 would return; the solution is written for SR_SOLVED and
+            SR_MULTIPLE, and possibly for SR_ABORTED
+*/
+solve_status solve_sudoku_9x9_into(const sudoku *input, sudoku *solution, const solve_options *options);
+
+/*
+    Runs a single engine.
+
+    \param engine the engine to run
+    \param allocator where to allocate the working memory and the solution, or NULL for malloc
+    \param input the sudoku to be solved
+    \param options the settings of the search (the engine decides the value order)
+
+    \return the same as solve_sudoku_with
+*/
+solve_result solve_sudoku_engine(solve_engine engine, const sudoku_allocator *allocator, const sudoku *input,
+                                 const solve_options *options);
+
+/*
+    Solves a sudoku by searching for its first solution twice, once trying the values of a cell in
+    ascending order and once in descending order, and comparing the two. Both searches walk the
+    same tree, as the cell or column branched on never depends on the value order, and so find its
+    leftmost and its rightmost solution: the same one if and only if there is a single one. On a
+    sudoku with a unique solution, this spares going through the rest of the tree after finding it.
+
+    Sudokus of size 3 are searched by the 9x9 engine, the others by the bitset engine (and so by
+    dancing links past BITSET_MAX_SIZE).
+
+    \param input the sudoku to be solved
+    \param options the node budget of each search, the cancellation flag and where to write the
+           number of search nodes of both searches; the other settings are ignored
+    \param threaded run the two searches in parallel threads, which only pays off for searches
+           far longer than starting a thread
+
+    \return the same as solve_sudoku_with, with the solution found in ascending order
+*/
+solve_result solve_sudoku_dual(const sudoku *input, const solve_options *options, bool threaded);
+
+/*
+    Solves a sudoku by running several engines at once, one thread each. The first engine to find
+    out whether the sudoku has no, one or several solutions wins, and the others stop at their
+    next search node.
+
+    \param input the sudoku to be solved
+    \param engines the engines to race, or NULL for all of them (but the 9x9 engine for sudokus of
+           any other size, and the bitset engine for sudokus larger than BITSET_MAX_SIZE, where
+           they would only be dancing links again)
+    \param noEngines the number of engines in the array
+
+    \return the result of the winning engine, like solve_sudoku
+*/
+solve_result solve_sudoku_portfolio(const sudoku *input, const solve_engine *engines, unsigned noEngines);
+
+#endif /* end of include guard: SUDOKU_PORTFOLIO_H */
@@ -0,0 +1,133 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "sudoku_progress.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <time.h>
+#include <pthread.h>
+
+struct progress_reporter {
+    const solve_progress *progress;
+    FILE *output;
+    unsigned interval;
+    int stop; //< set by stop_progress_reporter before it wakes the thread up
+
+    struct timespec start; //< when the reporter was started
+    struct timespec lastTime; //< when the last report was written
+    unsigned long lastNodes; //< the number of nodes at the last report
+
+    pthread_t thread;
+};
+
+/*
+    Calculates the number of seconds between two points in time.
+*/
+static double seconds_between(const struct timespec *from, const struct timespec *to) {
+    return (to->tv_sec - from->tv_sec) + (to->tv_nsec - from->tv_nsec) / 1e9;
+}
+
+double estimate_progress(const solve_progress *progress) {
+    unsigned depth = __atomic_load_n(&progress->depth, __ATOMIC_RELAXED);
+    if(depth > PROGRESS_LEVELS) {
+        depth = PROGRESS_LEVELS;
+    }
+
+    // Every branch before the one taken at a level is a finished subtree of that level.
+    double fraction = 0;
+    double subtree = 1;
+    for(unsigned level = 0; level < depth; ++level) {
+        unsigned noBranches = __atomic_load_n(&progress->noBranches[level], __ATOMIC_RELAXED);
+        unsigned branch = __atomic_load_n(&progress->branch[level], __ATOMIC_RELAXED);
+        if(noBranches == 0 || branch >= noBranches) {
+            break; // Caught in the middle of an update.
+        }
+        subtree /= noBranches;
+        fraction += branch * subtree;
+    }
+    return fraction;
+}
+
+/*
+    Writes a line about how far the search got, and the speed since the last report.
+
+    \param reporter the reporter
+*/
+static void report(progress_reporter *reporter) {
+    const solve_progress *progress = reporter->progress;
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    unsigned long noNodes = __atomic_load_n(&progress->noNodes, __ATOMIC_RELAXED);
+    double elapsed = seconds_between(&reporter->lastTime, &now);
+    double rate = elapsed > 0 ? (noNodes - reporter->lastNodes) / elapsed : 0;
+
+    fprintf(reporter->output, "progress: %.1f s, %lu nodes, %.0f nodes/s, depth %u/%u, %.2f%% explored\n",
+            seconds_between(&reporter->start, &now), noNodes, rate,
+            __atomic_load_n(&progress->depth, __ATOMIC_RELAXED), progress->maxDepth,
+            100 * estimate_progress(progress));
+    fflush(reporter->output);
+
+    reporter->lastTime = now;
+    reporter->lastNodes = noNodes;
+}
+
+/*
+    Reporter thread: reports every interval or on SIGUSR1, until stopped.
+
+    \param args the reporter
+*/
+static void *report_loop(void *args) {
+    progress_reporter *reporter = args;
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGUSR1);
+    const struct timespec interval = {reporter->interval, 0};
+
+    while(true) {
+        if(reporter->interval > 0) {
+            sigtimedwait(&signals, NULL, &interval);
+        }
+        else {
+            int received;
+            sigwait(&signals, &received);
+        }
+        if(__atomic_load_n(&reporter->stop, __ATOMIC_ACQUIRE)) {
+            break;
+        }
+        report(reporter);
+    }
+
+    return NULL;
+}
+
+progress_reporter *start_progress_reporter(const solve_progress *progress, FILE *output, unsigned interval) {
+    progress_reporter *reporter = malloc(sizeof(progress_reporter));
+    assert(reporter != NULL);
+    reporter->progress = progress;
+    reporter->output = output;
+    reporter->interval = interval;
+    reporter->stop = 0;
+    clock_gettime(CLOCK_MONOTONIC, &reporter->start);
+    reporter->lastTime = reporter->start;
+    reporter->lastNodes = 0;
+
+    // The reporter inherits the blocked signal and takes it with sigwait.
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &signals, NULL);
+
+    pthread_create(&reporter->thread, NULL, report_loop, reporter);
+    return reporter;
+}
+
+void stop_progress_reporter(progress_reporter *reporter) {
+    __atomic_store_n(&reporter->stop, 1, __ATOMIC_RELEASE);
+    pthread_kill(reporter->thread, SIGUSR1);
+    pthread_join(reporter->thread, NULL);
+
+    report(reporter);
+    free(reporter);
+}
@@ -0,0 +1,66 @@
+/*
+    \file sudoku_progress.h
+    \brief Live progress reports of a long dancing links search
+
+    A search given a solve_progress (through solve_options) publishes how far it got as it goes:
+    the number of nodes visited, its current depth and which branch it is on at each of the top
+    levels of the tree. A reporter thread reads those on a timer, or whenever the process receives
+    SIGUSR1, and writes a line about them, so a search that runs for minutes can be told apart from
+    one that is stuck.
+
+    The search only stores a few words per node with relaxed atomics, so the reports may mix
+    values from neighbouring nodes, which doesn't matter for an estimate.
+*/
+
+#ifndef SUDOKU_PROGRESS_H
+#define SUDOKU_PROGRESS_H
+
+#include <stdio.h>
+
+// The number of levels at the top of the tree whose branches are used to estimate the progress.
+// Many of the first levels of a sudoku are forced moves with a single branch, so this reaches deep.
+#define PROGRESS_LEVELS 256
+
+/*
+    How far a search got, written by the search and read by a reporter.
+*/
+typedef struct {
+    unsigned long noNodes; //< the number of search nodes visited so far
+    unsigned depth; //< the depth of the node being visited
+    unsigned maxDepth; //< the depth of a solution: the number of empty cells of the sudoku
+    unsigned branch[PROGRESS_LEVELS]; //< the index of the branch taken at each top level
+    unsigned noBranches[PROGRESS_LEVELS]; //< the number of branches at each top level
+} solve_progress;
+
+typedef struct progress_reporter progress_reporter;
+
+/*
+    Starts a thread reporting on a search. SIGUSR1 is blocked in the calling thread, and stays so,
+    for the reporter to receive it; start the reporter before any other thread so they inherit it.
+
+    \param progress the progress published by the search, zero-initialized before it starts
+    \param output where to write the reports
+    \param interval the number of seconds between two reports, or 0 to only report on SIGUSR1
+
+    \return the reporter, to be given to stop_progress_reporter
+*/
+progress_reporter *start_progress_reporter(const solve_progress *progress, FILE *output, unsigned interval);
+
+/*
+    Writes a last report, stops the reporter thread and frees it.
+
+    \param reporter the reporter to stop
+*/
+void stop_progress_reporter(progress_reporter *reporter);
+
+/*
+    Estimates the fraction of the search tree explored so far, assuming the subtrees of a node are
+    all the same size, from the branches taken at the top levels.
+
+    \param progress the progress published by the search
+
+    \return a number between 0 and 1
+*/
+double estimate_progress(const solve_progress *progress);
+
+#endif /* end of include guard: SUDOKU_PROGRESS_H */
@@ -0,0 +1,238 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "sudoku_protocol.h"
+#include "sudoku_io.h"
+#include <assert.h>
+#include <ctype.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+// Largest payload accepted: a size byte and the cells of an 81x81 sudoku.
+#define MAX_PAYLOAD (1 + 81 * 81)
+
+static void put_length(unsigned char *dest, uint32_t length) {
+    dest[0] = (unsigned char) (length >> 24);
+    dest[1] = (unsigned char) (length >> 16);
+    dest[2] = (unsigned char) (length >> 8);
+    dest[3] = (unsigned char) length;
+}
+
+/*
+    Reads the length prefix of a frame.
+
+    \param input the stream to read from
+
+    \return the payload length, or -1 if the stream ended or the length is out of range
+*/
+static long read_length(FILE *input) {
+    unsigned char prefix[4];
+    if(fread(prefix, 1, 4, input) != 4) {
+        return -1;
+    }
+    long length = ((long) prefix[0] << 24) | ((long) prefix[1] << 16) | ((long) prefix[2] << 8) | prefix[3];
+    return length <= MAX_PAYLOAD ? length : -1;
+}
+
+/*
+    Decodes a size byte followed by cells into a new sudoku.
+
+    \param payload the bytes to decode
+    \param length the number of bytes in the payload
+
+    \return a new heap-allocated sudoku, or NULL if the payload doesn't hold a whole sudoku
+*/
+static sudoku *decode_sudoku(const unsigned char *payload, long length) {
+    if(length < 1) {
+        return NULL;
+    }
+    unsigned size = payload[0];
+    if(size < 1 || size > 9 || (long) (1 + size * size * size * size) != length) {
+        return NULL;
+    }
+
+    sudoku *s = create_sudoku(size);
+    for(long i = 1; i < length; ++i) {
+        if(payload[i] > size * size) {
+            free_sudoku(s);
+            return NULL;
+        }
+        s->cells[i - 1] = payload[i];
+    }
+    return s;
+}
+
+/*
+    Encodes a sudoku as a size byte followed by its cells.
+
+    \param s the sudoku to encode
+    \param dest buffer with room for MAX_PAYLOAD bytes
+
+    \return the number of bytes written
+*/
+static long encode_sudoku(const sudoku *s, unsigned char *dest) {
+    assert(s->size <= 9);
+    const unsigned noCells = get_no_cells(s);
+    dest[0] = (unsigned char) s->size;
+    for(unsigned i = 0; i < noCells; ++i) {
+        dest[1 + i] = (unsigned char) s->cells[i];
+    }
+    return 1 + noCells;
+}
+
+/*
+    Fills in a socket address for the given path.
+
+    \param address the address to fill in
+    \param path the path of the socket
+
+    \return 0 on success, -1 if the path is too long
+*/
+static int socket_address(struct sockaddr_un *address, const char *path) {
+    memset(address, 0, sizeof(*address));
+    address->sun_family = AF_UNIX;
+    if(strlen(path) >= sizeof(address->sun_path)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    strcpy(address->sun_path, path);
+    return 0;
+}
+
+int listen_on_socket(const char *path) {
+    struct sockaddr_un address;
+    if(socket_address(&address, path) != 0) {
+        return -1;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(fd < 0) {
+        return -1;
+    }
+
+    unlink(path);
+    if(bind(fd, (struct sockaddr*) &address, sizeof(address)) != 0 || listen(fd, SOMAXCONN) != 0) {
+        int error = errno;
+        close(fd);
+        errno = error;
+        return -1;
+    }
+    return fd;
+}
+
+int connect_to_socket(const char *path) {
+    struct sockaddr_un address;
+    if(socket_address(&address, path) != 0) {
+        return -1;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(fd < 0) {
+        return -1;
+    }
+
+    if(connect(fd, (struct sockaddr*) &address, sizeof(address)) != 0) {
+        int error = errno;
+        close(fd);
+        errno = error;
+        return -1;
+    }
+    return fd;
+}
+
+int next_request_is_frame(FILE *input) {
+    int c;
+    do {
+        c = fgetc(input);
+    } while(c != EOF && c != 0 && isspace(c));
+
+    if(c == EOF) {
+        return -1;
+    }
+    ungetc(c, input);
+    return c == 0;
+}
+
+int write_sudoku_frame(FILE *output, const sudoku *s) {
+    unsigned char frame[4 + MAX_PAYLOAD];
+    long length = encode_sudoku(s, frame + 4);
+    put_length(frame, length);
+    return fwrite(frame, 1, 4 + length, output) == (size_t) (4 + length) ? 0 : -1;
+}
+
+sudoku *read_sudoku_frame(FILE *input) {
+    unsigned char payload[MAX_PAYLOAD];
+    long length = read_length(input);
+    if(length < 0 || fread(payload, 1, length, input) != (size_t) length) {
+        return NULL;
+    }
+    return decode_sudoku(payload, length);
+}
+
+int write_result_frame(FILE *output, solve_status status, const sudoku *solution) {
+    unsigned char frame[4 + 1 + MAX_PAYLOAD];
+    long length = 1;
+    frame[4] = (unsigned char) status;
+    if(status == SR_SOLVED) {
+        length += encode_sudoku(solution, frame + 5);
+    }
+    put_length(frame, length);
+    return fwrite(frame, 1, 4 + length, output) == (size_t) (4 + length) ? 0 : -1;
+}
+
+int write_error_frame(FILE *output) {
+    unsigned char frame[4 + 1];
+    put_length(frame, 1);
+    frame[4] = RESULT_ERROR;
+    return fwrite(frame, 1, sizeof(frame), output) == sizeof(frame) ? 0 : -1;
+}
+
+int read_result_frame(FILE *input, solve_status *status, sudoku **solution) {
+    unsigned char payload[1 + MAX_PAYLOAD];
+    long length = read_length(input);
+    if(length < 1 || fread(payload, 1, length, input) != (size_t) length) {
+        return -1;
+    }
+    if(length == 1 && payload[0] == RESULT_ERROR) {
+        return 1;
+    }
+    if(payload[0] > SR_NO_MEMORY) {
+        return -1;
+    }
+
+    *status = (solve_status) payload[0];
+    *solution = NULL;
+    if(*status == SR_SOLVED) {
+        *solution = decode_sudoku(payload + 1, length - 1);
+        if(*solution == NULL) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+void write_result_text(FILE *output, solve_status status, const sudoku *solution) {
+    fprintf(output, "%s\n", solve_status_name(status));
+    if(status == SR_SOLVED) {
+        write_sudoku(output, solution);
+    }
+}
+
+const char *solve_status_name(solve_status status) {
+    switch(status) {
+        case SR_SOLVED:
+            return "SOLVED";
+        case SR_MULTIPLE:
+            return "MULTIPLE";
+        case SR_UNSOLVABLE:
+            return "UNSOLVABLE";
+        case SR_ABORTED:
+            return "ABORTED";
+        case SR_NO_MEMORY:
+            return "OUT_OF_MEMORY";
+    }
+    return "UNKNOWN";
+}
@@ -0,0 +1,126 @@
+/*
+    \file sudoku_protocol.h
+    \brief The request and response framing used by sudoku_server and its clients
+
+    Every request is either
+        - a sudoku in the text format read by read_sudoku, answered with a status line (SOLVED,
+          MULTIPLE or UNSOLVABLE), followed by the solution in the format of write_sudoku if
+          the status is SOLVED. A malformed one (see read_sudoku_checked) is answered with an
+          ERROR line, and the connection closed, or
+        - a binary frame: a 4-byte big-endian payload length, then the size of the sudoku as one
+          byte and one byte per cell. It is answered with a frame holding the status as one byte,
+          followed by the solution (size byte and cells) if the status is SOLVED. A malformed
+          one is answered with a frame holding only RESULT_ERROR, and the connection closed.
+
+    A text request starts with a digit and a frame with a zero byte (payloads are far shorter than
+    2^24 bytes), so both kinds can be mixed on the same connection.
+*/
+
+#ifndef SUDOKU_PROTOCOL_H
+#define SUDOKU_PROTOCOL_H
+
+#include "sudoku.h"
+#include "sudoku_solve.h"
+#include <stdio.h>
+
+// The status byte of the response frame answering a malformed request frame.
+#define RESULT_ERROR 0xFF
+
+/*
+    Creates a Unix domain socket listening on the given path, replacing any stale socket file.
+
+    \param path the path of the socket
+
+    \return the listening socket, or -1 on error (with errno set)
+*/
+int listen_on_socket(const char *path);
+
+/*
+    Connects to a Unix domain socket.
+
+    \param path the path of the socket
+
+    \return the connected socket, or -1 on error (with errno set)
+*/
+int connect_to_socket(const char *path);
+
+/*
+    Checks if the next request on a stream is a binary frame, without consuming it.
+
+    \param input the stream to look at
+
+    \return 1 for a binary frame, 0 for a text request, -1 if the stream ended
+*/
+int next_request_is_frame(FILE *input);
+
+/*
+    Writes a sudoku as a binary request frame.
+
+    \param output the stream to write to
+    \param s the sudoku to send
+
+    \return 0 on success, -1 on a write error
+*/
+int write_sudoku_frame(FILE *output, const sudoku *s);
+
+/*
+    Reads a binary request frame.
+
+    \param input the stream to read from
+
+    \return a new heap-allocated sudoku, or NULL if the stream ended or the frame is malformed
+*/
+sudoku *read_sudoku_frame(FILE *input);
+
+/*
+    Writes a result as a binary response frame.
+
+    \param output the stream to write to
+    \param status the result of solving the sudoku
+    \param solution the solution, only written if the status is SR_SOLVED
+
+    \return 0 on success, -1 on a write error
+*/
+int write_result_frame(FILE *output, solve_status status, const sudoku *solution);
+
+/*
+    Writes the response frame answering a malformed request frame.
+
+    \param output the stream to write to
+
+    \return 0 on success, -1 on a write error
+*/
+int write_error_frame(FILE *output);
+
+/*
+    Reads a binary response frame.
+
+    \param input the stream to read from
+    \param status filled in with the result
+    \param solution filled in with a new heap-allocated solution if the status is SR_SOLVED,
+                    NULL otherwise
+
+    \return 0 on success, 1 if the server rejected the request (a RESULT_ERROR frame), -1 if the
+            stream ended or the frame is malformed
+*/
+int read_result_frame(FILE *input, solve_status *status, sudoku **solution);
+
+/*
+    Writes a result as a text response.
+
+    \param output the stream to write to
+    \param status the result of solving the sudoku
+    \param solution the solution, only written if the status is SR_SOLVED
+*/
+void write_result_text(FILE *output, solve_status status, const sudoku *solution);
+
+/*
+    Converts a solve status to the word used by the text responses.
+
+    \param status the status to convert
+
+    \return SOLVED, MULTIPLE, UNSOLVABLE, ABORTED or OUT_OF_MEMORY
+*/
+const char *solve_status_name(solve_status status);
+
+#endif /* end of include guard: SUDOKU_PROTOCOL_H */
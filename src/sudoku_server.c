@@ -0,0 +1,221 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "sudoku_io.h"
+#include "sudoku_solve.h"
+#include "sudoku_checking.h"
+#include "sudoku_canon.h"
+#include "sudoku_protocol.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <signal.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+// Maximum number of results every worker keeps between requests.
+static const unsigned CACHE_CAPACITY = 10000;
+
+typedef struct {
+    int listenFd; //< the socket every worker accepts connections from
+} worker_args;
+
+/*
+    What a worker keeps warm between requests: the results of the previous ones, and the working
+    memory of the searches, grown to the largest sudoku seen so far.
+*/
+typedef struct {
+    solve_cache *cache;
+    void *scratch;
+    size_t scratchSize;
+} worker_state;
+
+/*
+    Answers a single request.
+
+    \param givenSudoku the sudoku to solve
+    \param worker the state of the worker answering it
+    \param solution filled in with a new heap-allocated solution, or NULL if there is none
+
+    \return the status to answer with
+*/
+static solve_status answer(const sudoku *givenSudoku, worker_state *worker, sudoku **solution) {
+    *solution = NULL;
+
+    switch(check_sudoku(givenSudoku)) {
+        case CR_INVALID:
+            return SR_UNSOLVABLE;
+        case CR_COMPLETE:
+            *solution = copy_sudoku(givenSudoku);
+            return SR_SOLVED;
+        case CR_INCOMPLETE:
+            break;
+    }
+
+    if(solve_scratch_size(givenSudoku->size) > worker->scratchSize) {
+        free(worker->scratch);
+        worker->scratchSize = solve_scratch_size(givenSudoku->size);
+        worker->scratch = malloc(worker->scratchSize);
+        assert(worker->scratch != NULL);
+    }
+
+    solve_result result;
+    if(givenSudoku->size > CANON_MAX_SIZE) {
+        // Too large to be put in canonical form, so solved without the cache.
+        result.solution = create_sudoku(givenSudoku->size);
+        result.status = solve_sudoku_into(givenSudoku, result.solution, worker->scratch, worker->scratchSize, 0);
+    }
+    else {
+        result = cached_solve_sudoku_into(worker->cache, givenSudoku, worker->scratch, worker->scratchSize);
+    }
+    if(result.status == SR_SOLVED) {
+        *solution = result.solution;
+    }
+    else if(result.solution != NULL) {
+        free_sudoku(result.solution);
+    }
+    return result.status;
+}
+
+/*
+    Handles every request sent on a connection, until the client closes it or sends something
+    that can't be parsed. A malformed request is answered with an ERROR line or a RESULT_ERROR
+    frame first.
+
+    \param fd the connected socket, closed when done
+    \param worker the state of the worker serving it
+*/
+static void serve_connection(int fd, worker_state *worker) {
+    int outFd = dup(fd);
+    FILE *input = fdopen(fd, "r");
+    FILE *output = outFd < 0 ? NULL : fdopen(outFd, "w");
+    if(input == NULL || output == NULL) {
+        if(input != NULL) {
+            fclose(input);
+        }
+        else {
+            close(fd);
+        }
+        if(output != NULL) {
+            fclose(output);
+        }
+        else if(outFd >= 0) {
+            close(outFd);
+        }
+        return;
+    }
+
+    int isFrame;
+    while((isFrame = next_request_is_frame(input)) >= 0) {
+        read_status readStatus = READ_MALFORMED;
+        sudoku *givenSudoku = isFrame ? read_sudoku_frame(input) : read_sudoku_checked(input, &readStatus);
+        if(givenSudoku == NULL) {
+            // Where the next request would start can't be told, so the connection ends here.
+            if(isFrame) {
+                write_error_frame(output);
+            }
+            else if(readStatus == READ_MALFORMED) {
+                fprintf(output, "%s\n", "ERROR");
+            }
+            break;
+        }
+
+        sudoku *solution;
+        solve_status status = answer(givenSudoku, worker, &solution);
+
+        if(isFrame) {
+            write_result_frame(output, status, solution);
+        }
+        else {
+            write_result_text(output, status, solution);
+        }
+
+        free_sudoku(givenSudoku);
+        if(solution != NULL) {
+            free_sudoku(solution);
+        }
+        if(fflush(output) != 0) {
+            break; // The client went away.
+        }
+    }
+
+    fclose(input);
+    fclose(output);
+}
+
+/*
+    Worker thread body: accepts connections and serves them one at a time, keeping its result
+    cache and its search memory warm for as long as the server runs.
+
+    \param arg a worker_args structure
+*/
+static void *serve_worker(void *arg) {
+    worker_args *args = arg;
+    worker_state worker = {create_solve_cache(CACHE_CAPACITY), NULL, 0};
+
+    for(;;) {
+        int fd = accept(args->listenFd, NULL, NULL);
+        if(fd < 0) {
+            if(errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            perror("accept");
+            break;
+        }
+        serve_connection(fd, &worker);
+    }
+
+    free_solve_cache(worker.cache);
+    free(worker.scratch);
+    return NULL;
+}
+
+/*
+    Usage: sudoku_server SOCKET [THREADS]
+
+    Listens on the Unix domain socket SOCKET and answers the requests described in
+    sudoku_protocol.h with a pool of THREADS workers (one per core by default), until it gets
+    SIGINT or SIGTERM. A worker serves one connection at a time, from accept until the client
+    closes it, so at most THREADS connections are served at once and the others wait to be
+    accepted until one closes.
+*/
+int main(int argc, char **argv) {
+    if(argc < 2) {
+        fprintf(stderr, "Usage: %s SOCKET [THREADS]\n", argv[0]);
+        return 1;
+    }
+
+    const char *path = argv[1];
+    long noThreads = argc > 2 ? strtol(argv[2], NULL, 10) : sysconf(_SC_NPROCESSORS_ONLN);
+    if(noThreads < 1) {
+        noThreads = 1;
+    }
+
+    // Workers inherit this mask, so only the main thread ever sees the termination signals.
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    int listenFd = listen_on_socket(path);
+    if(listenFd < 0) {
+        perror(path);
+        return 1;
+    }
+
+    worker_args args = {listenFd};
+    for(long i = 0; i < noThreads; ++i) {
+        pthread_t thread;
+        pthread_create(&thread, NULL, serve_worker, &args);
+        pthread_detach(thread);
+    }
+
+    int received;
+    sigwait(&signals, &received);
+
+    close(listenFd);
+    unlink(path);
+    return 0;
+}
@@ -1,6 +1,9 @@
 #include "sudoku_solve.h"
 #include "sudoku_io.h"
 #include "sudoku_checking.h"
+#include "sudoku_kernels.h"
+#include "sudoku_portfolio.h"
+#include "sudoku_trace.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -10,7 +13,14 @@
 typedef struct {
     int no_solutions;
     sudoku *current;
-    sudoku *solution;
+    sudoku *solution; //< the last solution found, written into `destination` if there is one
+    sudoku *destination; //< where to write solutions, or NULL to allocate one on the first solution
+    unsigned long noNodes; //< number of search nodes visited so far
+    unsigned long maxNodes; //< give up after visiting this many nodes (0 for no limit)
+    const int *cancel; //< give up once this becomes non-zero (NULL for never)
+    const sudoku_allocator *allocator; //< where solutions are allocated
+    const sudoku_kernels *kernels; //< the kernels specialized for this size, or NULL
+    bool outOfMemory; //< set if a solution couldn't be allocated, which stops the search
 } solve_state;
 
 
@@ -46,21 +56,58 @@ static bool check_update(const sudoku *s, position pos) {
 }
 
 
+/*
+    Checks if the specialized kernels can be used for a sudoku: there must be an instance for its
+    size, and all its values must be in range.
+
+    \param s the sudoku to be solved
+
+    \returns true if the kernels of its size can be used
+*/
+static bool kernels_apply(const sudoku *s) {
+    if(get_kernels(s->size) == NULL) {
+        return false;
+    }
+    const unsigned noCells = get_no_cells(s);
+    const int maxValue = s->size * s->size;
+    for(unsigned i = 0; i < noCells; ++i) {
+        if(s->cells[i] < 0 || s->cells[i] > maxValue) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+    Checks if the search went over its node budget, was cancelled or ran out of memory.
+
+    \param state intermediate solving state
+
+    \returns true if the search should stop without a verdict
+*/
+static bool solve_aborted(const solve_state *state) {
+    return (state->maxNodes != 0 && state->noNodes >= state->maxNodes) || state->outOfMemory
+        || (state->cancel != NULL && __atomic_load_n(state->cancel, __ATOMIC_RELAXED) != 0);
+}
+
 /*
     \param state intermediate solving state
     \param startPoint check from this point onwards
 */
 static void solve(solve_state *state, unsigned startPoint) {
-    if(state->no_solutions < 2) {
+    if(state->no_solutions < 2 && !solve_aborted(state)) {
+        state->noNodes++;
         const unsigned onCells = get_no_cells(state->current);
         const unsigned valMax = state->current->size * state->current->size;
 
         for(unsigned i = startPoint; i < onCells; ++i) {
             if(state->current->cells[i] == 0) {
                 for(unsigned val = 1; val <= valMax; ++val) {
-                    position pos = index_to_position(state->current, i);
                     state->current->cells[i] = val;
-                    if(check_update(state->current, pos)) {
+                    bool valid = state->kernels != NULL
+                        ? state->kernels->check_update(state->current->cells, i)
+                        : check_update(state->current, index_to_position(state->current, i));
+                    if(valid) {
                         solve(state, i + 1);
                     }
                     state->current->cells[i] = 0;
@@ -69,56 +116,167 @@ static void solve(solve_state *state, unsigned startPoint) {
             }
         }
 
-        // If we reach this place, that means we found a solution.
-        state->no_solutions++;
-        if(state->no_solutions == 1) {
-            assert(state->solution == NULL);
-            state->solution = copy_sudoku(state->current);
-        }
-        else {
-            assert(state->solution != NULL);
-            free_sudoku(state->solution);
-            state->solution = copy_sudoku(state->current);
+        // If we reach this place, that means we found a solution. The second one overwrites the first.
+        if(state->solution == NULL) {
+            state->solution = state->destination != NULL ? state->destination
+                            : create_sudoku_with(state->allocator, state->current->size);
+            if(state->solution == NULL) {
+                state->outOfMemory = true;
+                return;
+            }
         }
+        state->no_solutions++;
+        memcpy(state->solution->cells, state->current->cells, sizeof(int) * get_no_cells(state->current));
     }
 }
 
 /*
-    Tries to solve the given sudoku.
-
-    This is using backtracking to solve it.
+    Tries to solve the given sudoku with backtracking, allocating all memory through the given
+    allocator.
 
+    /param allocator where to allocate the working copy and the solution, or NULL for malloc
     /param input the sudoku to be solved
+    /param options the node budget and cancellation flag of the search
+    /param destination where to write the solution, or NULL to allocate it through the allocator
 
-    /return the solve status of the sudoku (solved, unsolvable, or if multiple solutions were found)
+    /return the solve status of the sudoku (solved, unsolvable, multiple solutions found, or aborted)
             and a found solution, if possible
 
     /sa solve
 
 */
-solve_result solve_sudoku(const sudoku *given_sudoku) {
-    sudoku *sudokuCopy = copy_sudoku(given_sudoku);
-
+static solve_result solve_backtracking(const sudoku_allocator *allocator, const sudoku *given_sudoku,
+                                       const solve_options *options, sudoku *destination) {
+    sudoku *sudokuCopy = copy_sudoku_with(allocator, given_sudoku);
+    if(sudokuCopy == NULL) {
+        return (solve_result){SR_NO_MEMORY, NULL};
+    }
 
-    solve_state state = (solve_state){0,sudokuCopy,NULL};
+    solve_state state = (solve_state){0,sudokuCopy,NULL,destination,0,options->maxNodes,options->cancel,allocator,
+                                      kernels_apply(given_sudoku) ? get_kernels(given_sudoku->size) : NULL, false};
 
+    TRACE_BEGIN("solve");
     solve(&state, 0);
+    TRACE_END("solve");
 
-    free_sudoku(sudokuCopy);
+    free_sudoku_with(allocator, sudokuCopy);
+
+    if(options->noNodes != NULL) {
+        *options->noNodes = state.noNodes;
+    }
 
     solve_result result;
     switch (state.no_solutions) {
         case 0:
-            result.status = SR_UNSOLVABLE;
+            result.status = solve_aborted(&state) ? SR_ABORTED : SR_UNSOLVABLE;
             break;
         case 1:
-            result.status = SR_SOLVED;
+            result.status = solve_aborted(&state) ? SR_ABORTED : SR_SOLVED;
             break;
         default:
             result.status = SR_MULTIPLE;
             break;
     }
     result.solution = state.solution;
+    if(state.outOfMemory) {
+        // Only the first solution is allocated, so there is none to return.
+        result.status = SR_NO_MEMORY;
+    }
 
     return result;
 }
+
+/*
+    Tries to solve the given sudoku with backtracking, allocating all memory through the given
+    allocator.
+
+    /param allocator where to allocate the working copy and the solution, or NULL for malloc
+    /param input the sudoku to be solved
+    /param options the node budget and cancellation flag of the search
+
+    /return the same as solve_backtracking
+*/
+solve_result solve_sudoku_backtracking(const sudoku_allocator *allocator, const sudoku *given_sudoku, const solve_options *options) {
+    return solve_backtracking(allocator, given_sudoku, options, NULL);
+}
+
+#ifndef SUDOKU_ENGINE_ONLY
+
+/*
+    Computes how much memory solve_backtracking allocates for the sudokus of a given size: only
+    its working copy of the sudoku.
+
+    /param size the size of the sudokus
+
+    /return the number of bytes, counting the rounding of every block by the arena
+*/
+size_t solve_scratch_size(unsigned size) {
+    const size_t cellsSize = sizeof(int) * size * size * size * size;
+    return (sizeof(sudoku) + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT * ARENA_ALIGNMENT
+         + (cellsSize + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT * ARENA_ALIGNMENT;
+}
+
+/*
+    Tries to solve the given sudoku into a sudoku and with scratch memory owned by the caller.
+
+    /param input the sudoku to be solved
+    /param solution where to write the solution
+    /param scratch the working memory, of at least solve_scratch_size bytes
+    /param scratchSize the size of the working memory
+    /param maxNodes the node budget of the search, or 0 for an unbounded search
+
+    /return the solving status
+*/
+solve_status solve_sudoku_into(const sudoku *given_sudoku, sudoku *solution, void *scratch, size_t scratchSize,
+                               unsigned long maxNodes) {
+    assert(solution->size == given_sudoku->size);
+    sudoku_arena arena = {scratch, scratchSize, 0};
+    const sudoku_allocator allocator = arena_allocator(&arena);
+    solve_options options = {maxNodes, false, NULL, NULL, NULL, NULL, NULL, false};
+    return solve_backtracking(&allocator, given_sudoku, &options, solution).status;
+}
+
+/*
+    Tries to solve the given sudoku, allocating all memory through the given allocator and giving up
+    after visiting a given number of search nodes.
+
+    /param allocator where to allocate the working copy and the solution, or NULL for malloc
+    /param input the sudoku to be solved
+    /param maxNodes the node budget of the search, or 0 for an unbounded search
+
+    /return the same as solve_sudoku_backtracking
+*/
+solve_result solve_sudoku_with(const sudoku_allocator *allocator, const sudoku *given_sudoku, unsigned long maxNodes) {
+    solve_options options = {maxNodes, false, NULL, NULL, NULL, NULL, NULL, false};
+    return solve_sudoku_backtracking(allocator, given_sudoku, &options);
+}
+
+/*
+    Tries to solve the given sudoku.
+
+    /param input the sudoku to be solved
+
+    /return the solve status of the sudoku (solved, unsolvable, or if multiple solutions were found)
+            and a found solution, if possible
+
+    /sa solve_sudoku_with
+*/
+solve_result solve_sudoku(const sudoku *given_sudoku) {
+    return solve_sudoku_with(NULL, given_sudoku, 0);
+}
+
+/*
+    Tries to solve the given sudoku, giving up after visiting a given number of search nodes.
+
+    /param input the sudoku to be solved
+    /param maxNodes the node budget of the search, or 0 for an unbounded search
+
+    /return the same as solve_sudoku, or SR_ABORTED if the budget ran out first
+
+    /sa solve_sudoku_with
+*/
+solve_result solve_sudoku_bounded(const sudoku *given_sudoku, unsigned long maxNodes) {
+    return solve_sudoku_with(NULL, given_sudoku, maxNodes);
+}
+
+#endif /* SUDOKU_ENGINE_ONLY */
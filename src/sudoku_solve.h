@@ -8,7 +8,9 @@
 typedef enum {
     SR_SOLVED,      //< if the sudoku has been solved
     SR_MULTIPLE,    //< if there are multiple solutions to the sudoku
-    SR_UNSOLVABLE   //< if the given sudoku is unsolvable
+    SR_UNSOLVABLE,  //< if the given sudoku is unsolvable
+    SR_ABORTED,     //< if the search was stopped before reaching a verdict
+    SR_NO_MEMORY    //< if the allocator or the scratch memory ran out before a verdict was reached
 } solve_status;
 
 typedef struct {
@@ -29,4 +31,58 @@ typedef struct {
 */
 solve_result solve_sudoku(const sudoku *input);
 
+/*
+    Tries to solve the given sudoku, giving up once the search has visited a given number of nodes.
+
+    /param input the sudoku to be solved
+    /param maxNodes the node budget of the search, or 0 for an unbounded search
+
+    /return the same as solve_sudoku, or SR_ABORTED if the budget ran out before a verdict was
+            reached (a solution may still be returned if one was found)
+*/
+solve_result solve_sudoku_bounded(const sudoku *input, unsigned long maxNodes);
+
+/*
+    Tries to solve the given sudoku without touching any global state, allocating all its memory
+    through the given allocator. Safe to call from several threads at once.
+
+    /param allocator where to allocate the working memory and the solution (free it with
+                     free_sudoku_with), or NULL for malloc
+    /param input the sudoku to be solved
+    /param maxNodes the node budget of the search, or 0 for an unbounded search
+
+    /return the same as solve_sudoku_bounded, or SR_NO_MEMORY (without a solution) if the
+            allocator failed
+*/
+solve_result solve_sudoku_with(const sudoku_allocator *allocator, const sudoku *input, unsigned long maxNodes);
+
+/*
+    Computes how much scratch memory solve_sudoku_into needs for the sudokus of a given size.
+
+    /param size the size of the sudokus to be solved
+
+    /return the number of bytes
+*/
+size_t solve_scratch_size(unsigned size);
+
+/*
+    Tries to solve the given sudoku, writing the solution into a sudoku owned by the caller and
+    using only the caller's scratch memory, so that solving many sudokus with the same buffers
+    makes no heap allocations at all. Safe to call from several threads at once, each with their
+    own buffers.
+
+    /param input the sudoku to be solved
+    /param solution where to write the solution, if one is found: a sudoku of the same size, whose
+                    cells can be any buffer of the right length
+    /param scratch the working memory, aligned to ARENA_ALIGNMENT
+    /param scratchSize the size of the working memory, at least solve_scratch_size(input->size)
+    /param maxNodes the node budget of the search, or 0 for an unbounded search
+
+    /return the status solve_sudoku_bounded would return, or SR_NO_MEMORY if the scratch memory
+            is too small; the solution is written for SR_SOLVED and SR_MULTIPLE, and possibly
+            for SR_ABORTED
+*/
+solve_status solve_sudoku_into(const sudoku *input, sudoku *solution, void *scratch, size_t scratchSize,
+                               unsigned long maxNodes);
+
 #endif /* end of include guard: SUDOKU_SOLVE_H */
@@ -0,0 +1,445 @@
+#include "sudoku_portfolio.h"
+#include "sudoku_trace.h"
+#include <assert.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+/*
+    A search specialized for classic 9x9 sudokus (size 3), which make up most of the puzzles
+    solved and for which building an exact cover table costs far more than the search itself.
+
+    The board is an array of 81 candidate masks, value v being bit v-1, and a cell is solved once
+    its mask holds a single bit. Placing a value removes it from the 20 peers of the cell, and
+    every peer left with a single candidate is queued to be placed in turn (naked singles). Once
+    the queue is empty, a pass over the board finds the values left with a single place in a row,
+    column or box (hidden singles). The pass goes band by band: the three rows and the three boxes
+    of a band are the 27 consecutive masks of the band, and the columns are accumulated over the
+    bands, nine lanes at once, so the inner loops have constant bounds and no indirection for the
+    compiler to vectorize.
+
+    When neither rule places anything, the search guesses the values of the unsolved cell with the
+    fewest candidates in turn, each on a copy of the board: a little over 200 bytes on the stack,
+    so going back is just returning.
+*/
+
+// The size of the sudokus this engine solves.
+#define NINE_SIZE 3
+
+// The number of values, and of cells in a row, column or box.
+#define NINE_WIDTH 9
+
+#define NINE_CELLS 81
+
+// The mask of all the values.
+#define ALL_VALUES 0x1ff
+
+// The number of values in every mask of 9 bits.
+#define B2(n) n, n + 1, n + 1, n + 2
+#define B4(n) B2(n), B2(n + 1), B2(n + 1), B2(n + 2)
+#define B6(n) B4(n), B4(n + 1), B4(n + 1), B4(n + 2)
+#define B8(n) B6(n), B6(n + 1), B6(n + 1), B6(n + 2)
+static const unsigned char NO_VALUES[1 << NINE_WIDTH] = {B8(0), B8(1)};
+#undef B2
+#undef B4
+#undef B6
+#undef B8
+
+// The number of rows, columns and boxes.
+#define NINE_UNITS 27
+
+typedef struct {
+    uint16_t candidates[NINE_CELLS]; //< the values every cell can still take
+    uint16_t placed[NINE_UNITS]; //< the values placed in every row, then every column, then every box
+    unsigned noPlaced; //< the number of cells whose value was removed from their peers
+} nine_board;
+
+typedef struct {
+    int no_solutions; //< number of solutions found
+    sudoku *solution; //< the last solution found, written into `destination` if there is one
+    sudoku *destination; //< where to write solutions, or NULL to allocate one on the first solution
+    unsigned long noNodes; //< number of search nodes visited so far
+    unsigned long maxNodes; //< give up after visiting this many nodes (0 for no limit)
+    bool descending; //< try the largest value of a cell first
+    int maxSolutions; //< stop once this many solutions are found: 1, or 2 to tell whether there is a single one
+    const int *cancel; //< give up once this becomes non-zero (NULL for never)
+    const sudoku_allocator *allocator; //< where solutions are allocated
+    bool outOfMemory; //< set if a solution couldn't be allocated, which stops the search
+} nine_state;
+
+/*
+    Removes a value from a peer of a placed cell.
+
+    \param board the board
+    \param peer the cell to remove the value from
+    \param bit the value to remove
+    \param queue the cells left with a single candidate, waiting to be placed
+    \param noQueued the number of cells in the queue
+
+    \return false if the peer has no candidate left
+*/
+static bool remove_value(nine_board *board, unsigned peer, uint16_t bit, unsigned char *queue, unsigned *noQueued) {
+    const uint16_t candidates = board->candidates[peer];
+    if((candidates & bit) != 0) {
+        const uint16_t left = candidates & ~bit;
+        board->candidates[peer] = left;
+        if(left == 0) {
+            return false;
+        }
+        if((left & (left - 1)) == 0) {
+            queue[(*noQueued)++] = (unsigned char) peer;
+        }
+    }
+    return true;
+}
+
+/*
+    Removes the value of a solved cell from its row, column and box. The loops go over whole units
+    without an early exit, the cell itself being emptied meanwhile so that it is left alone, and
+    the count of queued cells is kept in a local for the compiler to keep in a register.
+
+    \return false if a peer has no candidate left
+*/
+static bool place(nine_board *board, unsigned cell, unsigned char *queue, unsigned *noQueued) {
+    const uint16_t bit = board->candidates[cell];
+    const unsigned row = cell / NINE_WIDTH;
+    const unsigned col = cell % NINE_WIDTH;
+    const unsigned box = (row / NINE_SIZE) * NINE_SIZE + col / NINE_SIZE;
+    board->placed[row] |= bit;
+    board->placed[NINE_WIDTH + col] |= bit;
+    board->placed[2 * NINE_WIDTH + box] |= bit;
+    board->noPlaced++;
+
+    unsigned queued = *noQueued;
+    bool alive = true;
+    board->candidates[cell] = 0;
+    for(unsigned i = 0; i < NINE_WIDTH; ++i) {
+        alive &= remove_value(board, row * NINE_WIDTH + i, bit, queue, &queued);
+        alive &= remove_value(board, i * NINE_WIDTH + col, bit, queue, &queued);
+    }
+    const unsigned boxCorner = (box / NINE_SIZE) * NINE_SIZE * NINE_WIDTH + (box % NINE_SIZE) * NINE_SIZE;
+    for(unsigned boxRow = 0; boxRow < NINE_SIZE; ++boxRow) {
+        for(unsigned boxCol = 0; boxCol < NINE_SIZE; ++boxCol) {
+            alive &= remove_value(board, boxCorner + boxRow * NINE_WIDTH + boxCol, bit, queue, &queued);
+        }
+    }
+    board->candidates[cell] = bit;
+    *noQueued = queued;
+    return alive;
+}
+
+/*
+    Settles a row, column or box, given which values appear in the candidates of at least one and
+    of at least two of its cells: every value must have a place, and the unsolved cells holding a
+    value with a single place are solved. A unit is walked as three runs of three cells.
+
+    \param board the board
+    \param unit the index of the unit in board->placed
+    \param first the first cell of the unit
+    \param runStep the distance between the first cells of the runs
+    \param cellStep the distance between the cells of a run
+    \param once the values among the candidates of at least one cell
+    \param twice the values among the candidates of at least two cells
+    \param queue the cells left with a single candidate, waiting to be placed
+    \param noQueued the number of cells in the queue
+
+    \return false if a value has no place left, or a cell two values with a single place
+*/
+static bool settle_unit(nine_board *board, unsigned unit, unsigned first, unsigned runStep, unsigned cellStep,
+                        uint16_t once, uint16_t twice, unsigned char *queue, unsigned *noQueued) {
+    if(once != ALL_VALUES) {
+        return false;
+    }
+    // Placed values are the only place of their value, but there is nothing left to do for them.
+    const uint16_t hidden = once & ~twice & ~board->placed[unit];
+    if(hidden == 0) {
+        return true;
+    }
+    for(unsigned run = 0; run < NINE_SIZE; ++run) {
+        for(unsigned i = 0; i < NINE_SIZE; ++i) {
+            const unsigned cell = first + run * runStep + i * cellStep;
+            const uint16_t candidates = board->candidates[cell];
+            const uint16_t single = candidates & hidden;
+            if(single != 0 && (candidates & (candidates - 1)) != 0) {
+                if((single & (single - 1)) != 0) {
+                    return false;
+                }
+                board->candidates[cell] = single;
+                queue[(*noQueued)++] = (unsigned char) cell;
+            }
+        }
+    }
+    return true;
+}
+
+/*
+    Looks for hidden singles in every row, column and box, band by band. The masks may be narrowed
+    while the pass goes on, which only makes the counts of the later units err on the safe side.
+
+    \return false if the board turned out to be a dead end
+*/
+static bool find_hidden_singles(nine_board *board, unsigned char *queue, unsigned *noQueued) {
+    uint16_t colOnce[NINE_WIDTH] = {0};
+    uint16_t colTwice[NINE_WIDTH] = {0};
+
+    for(unsigned band = 0; band < NINE_SIZE; ++band) {
+        const unsigned first = band * NINE_SIZE * NINE_WIDTH;
+        uint16_t boxOnce[NINE_SIZE] = {0};
+        uint16_t boxTwice[NINE_SIZE] = {0};
+
+        for(unsigned row = 0; row < NINE_SIZE; ++row) {
+            const uint16_t *candidates = &board->candidates[first + row * NINE_WIDTH];
+            uint16_t once = 0, twice = 0;
+            for(unsigned col = 0; col < NINE_WIDTH; ++col) {
+                twice |= once & candidates[col];
+                once |= candidates[col];
+                colTwice[col] |= colOnce[col] & candidates[col];
+                colOnce[col] |= candidates[col];
+            }
+            for(unsigned box = 0; box < NINE_SIZE; ++box) {
+                for(unsigned i = 0; i < NINE_SIZE; ++i) {
+                    boxTwice[box] |= boxOnce[box] & candidates[box * NINE_SIZE + i];
+                    boxOnce[box] |= candidates[box * NINE_SIZE + i];
+                }
+            }
+            if(!settle_unit(board, band * NINE_SIZE + row, first + row * NINE_WIDTH, NINE_SIZE, 1, once, twice,
+                            queue, noQueued)) {
+                return false;
+            }
+        }
+
+        for(unsigned box = 0; box < NINE_SIZE; ++box) {
+            if(!settle_unit(board, 2 * NINE_WIDTH + band * NINE_SIZE + box, first + box * NINE_SIZE, NINE_WIDTH, 1,
+                            boxOnce[box], boxTwice[box], queue, noQueued)) {
+                return false;
+            }
+        }
+    }
+
+    for(unsigned col = 0; col < NINE_WIDTH; ++col) {
+        if(!settle_unit(board, NINE_WIDTH + col, col, NINE_SIZE * NINE_WIDTH, NINE_WIDTH, colOnce[col], colTwice[col],
+                        queue, noQueued)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+    Places the queued cells and everything that follows from them by naked and hidden singles.
+
+    \param board the board
+    \param queue the cells solved but not placed yet, room for every cell
+    \param noQueued the number of cells in the queue
+
+    \return false if the board turned out to be a dead end
+*/
+static bool propagate(nine_board *board, unsigned char *queue, unsigned noQueued) {
+    for(;;) {
+        while(noQueued > 0) {
+            if(!place(board, queue[--noQueued], queue, &noQueued)) {
+                return false;
+            }
+        }
+        if(board->noPlaced == NINE_CELLS) {
+            return true;
+        }
+        if(!find_hidden_singles(board, queue, &noQueued)) {
+            return false;
+        }
+        if(noQueued == 0) {
+            return true;
+        }
+    }
+}
+
+static bool solve_aborted(const nine_state *state) {
+    return (state->maxNodes != 0 && state->noNodes >= state->maxNodes) || state->outOfMemory
+        || (state->cancel != NULL && __atomic_load_n(state->cancel, __ATOMIC_RELAXED) != 0);
+}
+
+/*
+    Searches for the solutions of a propagated board, stopping at the second one.
+
+    \param state the state of the search
+    \param board the board, which every guess copies
+*/
+static void search(nine_state *state, const nine_board *board) {
+    if(state->no_solutions >= state->maxSolutions || solve_aborted(state)) {
+        return;
+    }
+    state->noNodes++;
+
+    if(board->noPlaced == NINE_CELLS) {
+        // The second solution overwrites the first.
+        if(state->solution == NULL) {
+            state->solution = state->destination != NULL ? state->destination
+                            : create_sudoku_with(state->allocator, NINE_SIZE);
+            if(state->solution == NULL) {
+                state->outOfMemory = true;
+                return;
+            }
+        }
+        state->no_solutions++;
+        for(unsigned cell = 0; cell < NINE_CELLS; ++cell) {
+            state->solution->cells[cell] = __builtin_ctz(board->candidates[cell]) + 1;
+        }
+        return;
+    }
+
+    unsigned bestCell = 0;
+    unsigned bestCount = NINE_WIDTH + 1;
+    for(unsigned cell = 0; cell < NINE_CELLS && bestCount > 2; ++cell) {
+        const unsigned count = NO_VALUES[board->candidates[cell]];
+        if(count > 1 && count < bestCount) {
+            bestCell = cell;
+            bestCount = count;
+        }
+    }
+
+    uint16_t candidates = board->candidates[bestCell];
+    while(candidates != 0 && state->no_solutions < state->maxSolutions && !solve_aborted(state)) {
+        const uint16_t bit = state->descending ? (uint16_t) (1u << (31 - __builtin_clz(candidates)))
+                                               : candidates & -candidates;
+        candidates &= ~bit;
+
+        nine_board guess = *board;
+        unsigned char queue[NINE_CELLS];
+        guess.candidates[bestCell] = bit;
+        queue[0] = (unsigned char) bestCell;
+        if(propagate(&guess, queue, 1)) {
+            search(state, &guess);
+        }
+    }
+}
+
+/*
+    Sets up the board of a sudoku and propagates its givens. The givens are placed all at once,
+    from the values used in every row, column and box, rather than peer by peer.
+
+    \return false if a given is out of range or the givens lead to a dead end
+*/
+static bool fill_board(const sudoku *s, nine_board *board) {
+    uint16_t *rowUsed = board->placed;
+    uint16_t *colUsed = board->placed + NINE_WIDTH;
+    uint16_t *boxUsed = board->placed + 2 * NINE_WIDTH;
+    memset(board->placed, 0, sizeof(board->placed));
+    board->noPlaced = 0;
+    for(unsigned cell = 0; cell < NINE_CELLS; ++cell) {
+        const int value = s->cells[cell];
+        if(value < 0 || value > NINE_WIDTH) {
+            return false;
+        }
+        if(value != 0) {
+            const uint16_t bit = (uint16_t) (1u << (value - 1));
+            const unsigned row = cell / NINE_WIDTH, col = cell % NINE_WIDTH;
+            const unsigned box = (row / NINE_SIZE) * NINE_SIZE + col / NINE_SIZE;
+            if(((rowUsed[row] | colUsed[col] | boxUsed[box]) & bit) != 0) {
+                // Two givens clash.
+                return false;
+            }
+            rowUsed[row] |= bit;
+            colUsed[col] |= bit;
+            boxUsed[box] |= bit;
+            board->noPlaced++;
+        }
+    }
+
+    unsigned char queue[NINE_CELLS];
+    unsigned noQueued = 0;
+    for(unsigned cell = 0; cell < NINE_CELLS; ++cell) {
+        const unsigned row = cell / NINE_WIDTH, col = cell % NINE_WIDTH;
+        const unsigned box = (row / NINE_SIZE) * NINE_SIZE + col / NINE_SIZE;
+        if(s->cells[cell] != 0) {
+            board->candidates[cell] = (uint16_t) (1u << (s->cells[cell] - 1));
+            continue;
+        }
+        const uint16_t candidates = ALL_VALUES & ~(rowUsed[row] | colUsed[col] | boxUsed[box]);
+        board->candidates[cell] = candidates;
+        if(candidates == 0) {
+            return false;
+        }
+        if((candidates & (candidates - 1)) == 0) {
+            queue[noQueued++] = (unsigned char) cell;
+        }
+    }
+    return propagate(board, queue, noQueued);
+}
+
+/*
+    Solves a 9x9 sudoku.
+
+    \param allocator where to allocate the solution, or NULL for malloc
+    \param input the sudoku to be solved, of size 3
+    \param options the node budget, value order and cancellation flag of the search
+    \param destination where to write the solution, or NULL to allocate it through the allocator
+
+    \returns a solve result object which contains the solving status and a solution, if found
+*/
+static solve_result solve_9x9(const sudoku_allocator *allocator, const sudoku *input, const solve_options *options,
+                              sudoku *destination) {
+    assert(input->size == NINE_SIZE);
+    nine_state state = {0, NULL, destination, 0, options->maxNodes, options->descending,
+                         options->firstSolution ? 1 : 2, options->cancel, allocator, false};
+
+    TRACE_BEGIN("solve_9x9");
+    nine_board board;
+    if(fill_board(input, &board)) {
+        search(&state, &board);
+    }
+    TRACE_END("solve_9x9");
+
+    solve_result result;
+    switch (state.no_solutions) {
+        case 0:
+            result.status = solve_aborted(&state) ? SR_ABORTED : SR_UNSOLVABLE;
+            break;
+        case 1:
+            // A single solution is only known to be unique if the search was not cut short, or stopped
+            // right after it.
+            result.status = solve_aborted(&state) || state.maxSolutions == 1 ? SR_ABORTED : SR_SOLVED;
+            break;
+        default:
+            result.status = SR_MULTIPLE;
+            break;
+    }
+    result.solution = state.solution;
+    if(state.outOfMemory) {
+        // Only the first solution is allocated, so there is none to return.
+        result.status = SR_NO_MEMORY;
+    }
+
+    if(options->noNodes != NULL) {
+        *options->noNodes = state.noNodes;
+    }
+    return result;
+}
+
+/*
+    Solves a sudoku with the 9x9 engine, handing sudokus of any other size to dancing links.
+
+    \param allocator where to allocate the solution, or NULL for malloc
+    \param input the sudoku to be solved
+    \param options the node budget, value order and cancellation flag of the search
+
+    \returns a solve result object which contains the solving status and a solution, if found
+*/
+solve_result solve_sudoku_9x9(const sudoku_allocator *allocator, const sudoku *input, const solve_options *options) {
+    if(input->size != NINE_SIZE) {
+        return solve_sudoku_dlx(allocator, input, options);
+    }
+    return solve_9x9(allocator, input, options, NULL);
+}
+
+/*
+    Solves a 9x9 sudoku into a sudoku owned by the caller, without allocating anything.
+
+    \param input the sudoku to be solved, of size 3
+    \param solution where to write the solution
+    \param options the node budget, value order and cancellation flag of the search
+
+    \returns the solving status
+*/
+solve_status solve_sudoku_9x9_into(const sudoku *input, sudoku *solution, const solve_options *options) {
+    return solve_9x9(NULL, input, options, solution).status;
+}
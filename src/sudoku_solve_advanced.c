@@ -1,47 +1,115 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include "sudoku.h"
 #include "sudoku_io.h"
 #include "sudoku_solve.h"
+#include "sudoku_portfolio.h"
+#include "sudoku_checkpoint.h"
+#include "sudoku_trace.h"
 #include "sudoku_checking.h"
 #include <assert.h>
 #include <stdlib.h>
 #include <limits.h>
+#include <stdint.h>
 #include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
 
 /*
-    Structure used as a node for the 2d circular doubly linked list.
+    The nodes of the 2d circular doubly linked list are kept in a single array and refer to each
+    other by index, which halves the size of a node compared to pointers and keeps a whole table in
+    a few contiguous blocks. Index 0 is the head of the table, followed by one header per column
+    and then four nodes (one per constraint) for every candidate, in the order they were added.
+*/
+typedef uint32_t node_index;
 
+// The index of the head of every table.
+#define TABLE_HEAD 0
+
+/*
+    The links of a node: everything the search touches while covering and uncovering.
 */
 typedef struct table_links {
-    struct table_links *up;
-    struct table_links *down;
-    struct table_links *left;
-    struct table_links *right;
-    struct column_object *column; //< Pointer to the column this cell is a part of.
+    node_index up;
+    node_index down;
+    node_index left;
+    node_index right;
+    node_index column; //< The header of the column this node is a part of.
 } table_links;
 
-typedef struct column_object {
-    table_links links;
-    unsigned size; //< The number of elements in the array
-    char* name; //< The name of the column (useful for debugging)
-} column_object;
-
+/*
+    The candidate a row of the exact cover matrix stands for. Only read once a solution is found,
+    so it's kept apart from the links.
+*/
 typedef struct cell_object {
-    table_links links;
-    unsigned row; //< The row this constraint represents
-    unsigned col; //< The column this constraint represents
-    unsigned value; //< The value this constraint represents
+    unsigned char row; //< The row this constraint represents
+    unsigned char col; //< The column this constraint represents
+    unsigned char value; //< The value this constraint represents
 } cell_object;
 
-
 typedef struct constraint_table {
-    table_links *head;
+    table_links *links; //< the links of every node
+    unsigned *sizes; //< the number of elements in every column, indexed by its header
+    cell_object *cells; //< the candidate of every matrix row, in the order the rows were added
+    unsigned noColumns; //< the number of column headers, which follow the head
+    unsigned noNodes; //< the number of nodes in use
+    const sudoku_allocator *allocator; //< where all the nodes of the table are allocated
 } constraint_table;
 
+// Tables with fewer candidates than this are built by the calling thread alone, as starting
+// threads would take longer than building them.
+#define PARALLEL_BUILD_MIN_CANDIDATES (1u << 16)
+
+// The largest number of threads a table is built by.
+#define MAX_BUILD_THREADS 16
+
+/*
+    The nodes a band of rows adds to a column, chained from the first to the last.
+*/
+typedef struct column_segment {
+    node_index first; //< the first node, 0 if the band adds none
+    node_index last;
+    unsigned size; //< the number of nodes
+} column_segment;
+
+/*
+    The share of the work of building a table given to a thread (see generate_table).
+*/
+typedef struct table_band {
+    constraint_table *table; //< the table being built
+    const sudoku *s; //< the sudoku the table is built from
+    const uint128_t *rowUsed; //< the values used in every row of the sudoku
+    const uint128_t *colUsed; //< the values used in every column of the sudoku
+    const uint128_t *boxUsed; //< the values used in every box of the sudoku
+    unsigned firstRow; //< the first sudoku row of the band
+    unsigned lastRow; //< the sudoku row after the last one of the band
+    unsigned firstCandidate; //< the number of candidates of the rows above the band
+    unsigned lastCandidate; //< the number of candidates up to the end of the band
+    column_segment *segments; //< the segment of every column, by header, or NULL to link into the columns
+    const struct table_band *bands; //< all the bands, for stitching
+    unsigned noBands;
+    node_index firstColumn; //< the first column this band stitches
+    node_index lastColumn; //< the column after the last one this band stitches
+} table_band;
+
 typedef struct solve_state {
     int no_solutions; //< number of solutions found
-    sudoku *current; //< the sudoku we're trying to solve
-    cell_object **solutionObjects;
-    sudoku *solution;
+    const sudoku *current; //< the sudoku we're trying to solve
+    node_index *solutionObjects; //< the node of the matrix row chosen at every depth
+    unsigned *branches; //< the index of that row among the rows of its column, in search order
+    sudoku *solution; //< the last solution found, written into `destination` if there is one
+    sudoku *destination; //< where to write solutions, or NULL to allocate one on the first solution
+    unsigned long noNodes; //< number of search nodes visited so far
+    unsigned long maxNodes; //< give up after visiting this many nodes (0 for no limit)
+    bool descending; //< walk the rows of a column upwards, trying the largest value first
+    int maxSolutions; //< stop once this many solutions are found: 1, or 2 to tell whether there is a single one
+    const int *cancel; //< give up once this becomes non-zero (NULL for never)
+    solve_progress *progress; //< where to publish how far the search got (NULL for nowhere)
+    solve_checkpoint *checkpoint; //< where to save the position of the search (NULL for nowhere)
+    bool resuming; //< still skipping the subtrees explored before checkpoint->resume was saved
+    const sudoku_allocator *allocator; //< where solutions are allocated
+    bool outOfMemory; //< set if a solution couldn't be allocated, which stops the search
 } solve_state;
 
 
@@ -67,202 +135,155 @@ static unsigned no_empty_spaces(const sudoku *s) {
 }
 
 /*
-    Frees a column_object struct.
-
-    \param object the object to be freed
-*/
-static void free_column_object(column_object* object) {
-    free(object->name);
-    free(object);
-}
-
-/*
-    Frees a column, including all the elements attached to it.
-
-    \param header the header of the column to be freed
-*/
-static void free_column(column_object* header) {
-    table_links *current = header->links.down;
-    while(current != (table_links*) header) {
-        current = current->down;
-        free(current->up);
-    }
-    free_column_object(header);
-}
-
-/*
-    Frees all the values held in the constraint table
+    Frees all the values held in the constraint table, including a table only partly allocated
 
     \param table the constraint table to be freed
 */
 
 static void free_constraint_table(constraint_table *table) {
-    column_object *current = (column_object*) table->head->right;
-    while((table_links*) current != table->head) {
-        current = (column_object*) current->links.right;
-        free_column((column_object*) current->links.left);
+    const sudoku_allocator *allocator = table->allocator;
+    if(table->links != NULL) {
+        release_with(allocator, table->links);
+    }
+    if(table->sizes != NULL) {
+        release_with(allocator, table->sizes);
     }
-    free(table->head);
-    free(table);
+    if(table->cells != NULL) {
+        release_with(allocator, table->cells);
+    }
+    release_with(allocator, table);
 }
 
 /*
     Add a given node to the left of a node that's in a horizontal cyclic
     doubly linked list.
 
+    \param links the links of the table
     \param node the node relative to which we are adding
     \paran toAdd the node to be added to the left of `node`
 */
-static void link_left_of(table_links *node, table_links *toAdd) {
-    if(node == NULL) {
-        toAdd->right = toAdd;
-        toAdd->left = toAdd;
-    }
-    else {
-        toAdd->left = node->left;
-        node->left->right = toAdd;
-        node->left = toAdd;
-        toAdd->right = node;
-    }
+static void link_left_of(table_links *links, node_index node, node_index toAdd) {
+    links[toAdd].left = links[node].left;
+    links[links[node].left].right = toAdd;
+    links[node].left = toAdd;
+    links[toAdd].right = node;
 }
 
 /*
     Add a given node to above a node that's in a vertical cyclic
     doubly linked list.
 
+    \param links the links of the table
     \param node the node relative to which we are adding
     \param toAdd the node to be added to above `node`
 */
-static void link_above(table_links *node, table_links *toAdd) {
-    if(node == NULL) {
-        toAdd->down = toAdd;
-        toAdd->up = toAdd;
-    }
-    else {
-        toAdd->up = node->up;
-        toAdd->down = node;
-        node->up->down = toAdd;
-        node->up = toAdd;
-    }
+static void link_above(table_links *links, node_index node, node_index toAdd) {
+    links[toAdd].up = links[node].up;
+    links[toAdd].down = node;
+    links[links[node].up].down = toAdd;
+    links[node].up = toAdd;
 }
 
 /*
     Link the left and right neighbour of a given node together, leaving the
     covered node's links intact.
 
+    \param links the links of the table
     \param nodeToCover the node to be covered
 */
-static void cover_left_right(table_links *nodeToCover) {
-    nodeToCover->left->right = nodeToCover->right;
-    nodeToCover->right->left = nodeToCover->left;
+static void cover_left_right(table_links *links, node_index nodeToCover) {
+    links[links[nodeToCover].left].right = links[nodeToCover].right;
+    links[links[nodeToCover].right].left = links[nodeToCover].left;
 }
 
 /*
     Link the up and down neighbour of a given node together, leaving the
     covered node's links intact.
 
+    \param links the links of the table
     \param nodeToCover the node to be covered
 */
-static void cover_up_down( table_links *nodeToCover) {
-    nodeToCover->up->down = nodeToCover->down;
-    nodeToCover->down->up = nodeToCover->up;
+static void cover_up_down(table_links *links, node_index nodeToCover) {
+    links[links[nodeToCover].up].down = links[nodeToCover].down;
+    links[links[nodeToCover].down].up = links[nodeToCover].up;
 }
 
 /*
     Restore the left and right neighbour of a given node, using the given node's
     saved links.
 
+    \param links the links of the table
     \param nodeToCover the node to be uncovered
 */
-static void uncover_left_right(table_links *nodeToUncover) {
-    nodeToUncover->left->right = nodeToUncover;
-    nodeToUncover->right->left = nodeToUncover;
+static void uncover_left_right(table_links *links, node_index nodeToUncover) {
+    links[links[nodeToUncover].left].right = nodeToUncover;
+    links[links[nodeToUncover].right].left = nodeToUncover;
 }
 
 /*
     Restore the up and down neighbour of a given node, using the given node's
     saved links.
 
+    \param links the links of the table
     \param nodeToCover the node to be uncovered
 */
-static void uncover_up_down(table_links *nodeToUncover) {
-    nodeToUncover->down->up = nodeToUncover;
-    nodeToUncover->up->down = nodeToUncover;
+static void uncover_up_down(table_links *links, node_index nodeToUncover) {
+    links[links[nodeToUncover].down].up = nodeToUncover;
+    links[links[nodeToUncover].up].down = nodeToUncover;
 }
 
 /*
     Add an empty column to the constraint table
 
     \param table the table to add the column to
-    \param name the name of the column being added
-*/
-static column_object *add_column_header(constraint_table *table, char *name) {
-    column_object* columnObj = malloc(sizeof(column_object));
-    assert(columnObj != NULL);
 
-    columnObj->size = 0;
-    columnObj->name = name;
+    \return the header of the new column
+*/
+static node_index add_column_header(constraint_table *table) {
+    node_index header = table->noNodes++;
+    table_links *links = table->links;
 
-    columnObj->links.column = columnObj;
+    table->sizes[header] = 0;
 
-    link_above(NULL, &columnObj->links);
+    links[header].column = header;
+    links[header].up = header;
+    links[header].down = header;
 
-    link_left_of(table->head, &columnObj->links);
+    link_left_of(links, TABLE_HEAD, header);
 
-    return columnObj;
+    return header;
 }
 
 /*
-    Add a constraint (1 in the exact cover matrix) to the given column.
-
-    \param columnHeader the column to add to
-    \param row --
-    \param col -|-- values used to identify the matrix row.
-    \param val --
-*/
-static cell_object *add_constraint_to_column(column_object *columnHeader, unsigned row, unsigned col, unsigned val) {
-    cell_object* cellObj = malloc(sizeof(cell_object));
-    assert(cellObj != NULL);
+    Finds the candidate the matrix row of a given node stands for.
 
-    cellObj->links.column = columnHeader;
+    \param table the table the node is part of
+    \param node any of the four nodes of the matrix row
 
-    link_above(&columnHeader->links, &cellObj->links);
-
-    cellObj->row = row;
-    cellObj->col = col;
-    cellObj->value = val;
-    columnHeader->size++;
-
-    return cellObj;
+    \return the candidate of the matrix row
+*/
+static const cell_object *cell_of(const constraint_table *table, node_index node) {
+    return &table->cells[(node - table->noColumns - 1) / 4];
 }
 
 /*
-    Checks if the row, column and square corresponding to this position are invalid.
-
-    \param s the sudoke in which to check
-    \param pos the position around which to check
+    Adds a value to the set of values seen in a row, column or box. Seeing the
+    same value twice marks every value as used, so no candidate is ever placed
+    in a section that is already invalid.
 
-    \returns if any of the row, column or square are invalid
+    \param used the set of values already seen in the section
+    \param value the value to add (0 for an empty cell)
 */
-static bool check_update(const sudoku *s, position pos) {
-    int buffer[s->size * s->size];
-
-    get_row(s, pos.row, buffer);
-    if(check_list(buffer, s->size) == CR_INVALID) {
-        return false;
-    }
-
-    get_col(s, pos.col, buffer);
-    if(check_list(buffer, s->size) == CR_INVALID) {
-        return false;
-    }
-
-    get_square(s, pos.row / s->size, pos.col / s->size, buffer);
-    if(check_list(buffer, s->size) == CR_INVALID) {
-        return false;
+static void mark_used(uint128_t *used, int value) {
+    const uint128_t ONE = 1;
+    if(value != 0) {
+        if((*used & (ONE << value)) != 0) {
+            *used = ~(uint128_t) 0;
+        }
+        else {
+            *used |= ONE << value;
+        }
     }
-
-    return true;
 }
 
 /*
@@ -271,134 +292,323 @@ static bool check_update(const sudoku *s, position pos) {
     \param table the table to remove the zero-columns from
 */
 static void remove_zero_columns(constraint_table *table) {
-    column_object *current = (column_object*) table->head->right;
-
-    while((table_links*) current != table->head) {
-        if(current->size == 0) {;
-            cover_left_right(&current->links);
-            column_object *toDelete = current;
-            current = (column_object*) current->links.right;
-            free_column(toDelete);
-        } else {
-            current = (column_object*) current->links.right;
+    table_links *links = table->links;
+
+    for(node_index current = links[TABLE_HEAD].right; current != TABLE_HEAD; current = links[current].right) {
+        if(table->sizes[current] == 0) {
+            // The column keeps its own links, so the walk can carry on from it.
+            cover_left_right(links, current);
         }
     }
 }
 
 /*
-    Generates a constraint table from a given sudoku grid
+    Adds a node to the segment a band of rows builds of a column, or straight to the column for
+    the first band.
 
-    This firstly generates all the columns of the constraint table and then
-    fills them with 1s by iterating through all the possible rows, columns and,
-    if the spaces is empty, values (which is equivalent to iterating through all
-    the rows of the exact cover matrix) and add in the necessary 1s.
+    \param band the band the node is part of
+    \param column the header of the column
+    \param node the node to add
+*/
+static void add_to_segment(table_band *band, node_index column, node_index node) {
+    table_links *links = band->table->links;
+    links[node].column = column;
+
+    if(band->segments == NULL) {
+        link_above(links, column, node);
+        band->table->sizes[column]++;
+        return;
+    }
 
-    \param s the partially filled sudoku grid
+    column_segment *segment = &band->segments[column];
+    if(segment->first == 0) {
+        segment->first = node;
+    }
+    else {
+        links[segment->last].down = node;
+        links[node].up = segment->last;
+    }
+    segment->last = node;
+    segment->size++;
+}
 
-    \return the generated constraint table
-*/
-static constraint_table *generate_table(sudoku *s) {
-    constraint_table *table = malloc(sizeof(constraint_table));
-    assert(table != NULL);
+/*
+    Adds the matrix rows of a band of sudoku rows to a table. The nodes of the band go to the slice
+    of the table starting at its first candidate, so the bands can be built at the same time.
 
-    table->head = malloc(sizeof(table_links));
-    assert(table->head != NULL);
+    \param argument the band to build (a table_band)
+
+    \return NULL
+*/
+static void *build_band(void *argument) {
+    table_band *band = argument;
+    constraint_table *table = band->table;
+    table_links *links = table->links;
+    const sudoku *s = band->s;
+    const unsigned sectionSize = s->size * s->size;
+    const unsigned noCells = sectionSize * sectionSize;
+    const uint128_t ONE = 1;
 
-    link_left_of(NULL, table->head);
+    if(band->segments != NULL) {
+        memset(band->segments, 0, sizeof(column_segment) * (1 + table->noColumns));
+    }
 
-    unsigned sectionSize = s->size * s->size;
+    // Row-Column, Row-Number, Column-Number and Box-Number constraint columns
+    const node_index rowColumnHeaders = 1;
+    const node_index rowNumberHeaders = rowColumnHeaders + noCells;
+    const node_index columnNumberHeaders = rowNumberHeaders + noCells;
+    const node_index boxNumberHeaders = columnNumberHeaders + noCells;
 
-    column_object** rowColumnHeaders = malloc(sizeof(column_object*) * sectionSize * sectionSize);
-    assert(rowColumnHeaders != NULL);
+    unsigned candidate = band->firstCandidate;
+    for(unsigned row = band->firstRow; row < band->lastRow; ++row) {
+        for(unsigned col = 0; col < sectionSize; ++col) {
+            if(get_cell(s, row, col) == 0) {
+                unsigned box = (row / s->size) * s->size + col / s->size;
+                uint128_t used = band->rowUsed[row] | band->colUsed[col] | band->boxUsed[box];
 
-    //Add Row-Column constraint columns
-    for(unsigned r = 0; r < sectionSize; ++r) {
-        for(unsigned c = 0; c < sectionSize; ++c) {
-            char * name = malloc(sizeof(char) * 20);
-            assert(name != NULL);
-            sprintf(name, "R%dC%d", r + 1, c + 1);
-            rowColumnHeaders[r * sectionSize + c] = add_column_header(table, name);
+                for(unsigned val = 0; val < sectionSize; ++val) {
+                    if((used & (ONE << (val + 1))) == 0) {
+                        const node_index columns[4] = {
+                            rowColumnHeaders + row * sectionSize + col,
+                            rowNumberHeaders + row * sectionSize + val,
+                            columnNumberHeaders + col * sectionSize + val,
+                            boxNumberHeaders + box * sectionSize + val
+                        };
+                        const node_index first = 1 + table->noColumns + 4 * candidate;
+                        for(unsigned i = 0; i < 4; ++i) {
+                            links[first + i].left = first + (i + 3) % 4;
+                            links[first + i].right = first + (i + 1) % 4;
+                            add_to_segment(band, columns[i], first + i);
+                        }
+
+                        table->cells[candidate++] = (cell_object){row, col, val};
+                    }
+                }
+            }
         }
     }
+    assert(candidate == band->lastCandidate);
 
+    return NULL;
+}
+
+/*
+    Appends the segments the other bands built of a range of columns to the segment the first band
+    linked in, in band order, and closes the columns.
 
-    column_object** rowNumberHeaders = malloc(sizeof(column_object*) * sectionSize * sectionSize);
-    assert(rowNumberHeaders != NULL);
+    \param argument the band whose columns to stitch (a table_band, of the bands array)
 
-    //Add Row-Number constraint columns
-    for(unsigned r = 0; r < sectionSize; ++r) {
-        for(unsigned val = 0; val < sectionSize; ++val) {
-            char * name = malloc(sizeof(char) * 20);
-            assert(name != NULL);
-            sprintf(name, "R%d#%d", r + 1, val + 1);
-            rowNumberHeaders[r * sectionSize + val] = add_column_header(table, name);
+    \return NULL
+*/
+static void *stitch_columns(void *argument) {
+    const table_band *band = argument;
+    constraint_table *table = band->table;
+    table_links *links = table->links;
+
+    for(node_index column = band->firstColumn; column < band->lastColumn; ++column) {
+        node_index last = links[column].up;
+        for(unsigned i = 1; i < band->noBands; ++i) {
+            const column_segment *segment = &band->bands[i].segments[column];
+            if(segment->first != 0) {
+                links[last].down = segment->first;
+                links[segment->first].up = last;
+                last = segment->last;
+                table->sizes[column] += segment->size;
+            }
         }
+        links[last].down = column;
+        links[column].up = last;
     }
 
-    column_object** columnNumberHeaders = malloc(sizeof(column_object*) * sectionSize * sectionSize);
-    assert(columnNumberHeaders != NULL);
+    return NULL;
+}
+
+/*
+    Runs a task for every band, the first one on the calling thread and the others on threads of
+    their own, and waits for all of them. A band whose thread can't be started runs on the calling
+    thread.
 
-    //Add Column-Number constraint columns
-    for(unsigned c = 0; c < sectionSize; ++c) {
-        for(unsigned val = 0; val < sectionSize; ++val) {
-            char * name = malloc(sizeof(char) * 20);
-            assert(name != NULL);
-            sprintf(name, "C%d#%d", c + 1, val + 1);
-            columnNumberHeaders[c * sectionSize + val] = add_column_header(table, name);
+    \param task the task to run
+    \param bands the bands to give it
+    \param noBands the number of bands
+*/
+static void run_on_bands(void *(*task)(void *), table_band *bands, unsigned noBands) {
+    pthread_t threads[MAX_BUILD_THREADS];
+    bool started[MAX_BUILD_THREADS];
+    for(unsigned i = 1; i < noBands; ++i) {
+        started[i] = pthread_create(&threads[i], NULL, task, &bands[i]) == 0;
+    }
+    task(&bands[0]);
+    for(unsigned i = 1; i < noBands; ++i) {
+        if(started[i]) {
+            pthread_join(threads[i], NULL);
+        }
+        else {
+            task(&bands[i]);
         }
     }
+}
+
+/*
+    Chooses how many bands to build a table in.
 
-    column_object** boxNumberHeaders = malloc(sizeof(column_object*) * sectionSize * sectionSize);
-    assert(boxNumberHeaders != NULL);
+    \param noCandidates the number of candidates of the sudoku
+    \param sectionSize the number of rows of the sudoku
 
-    //Add Box-Number constraint columns
-    for(unsigned r = 0; r < s->size; ++r) {
-        for(unsigned c = 0; c < s->size; ++c) {
-            for(unsigned val = 0; val < sectionSize; ++val) {
-                char * name = malloc(sizeof(char) * 20);
-                assert(name != NULL);
-                sprintf(name, "BR%dC%d#%d", r + 1, c + 1, val + 1);
-                boxNumberHeaders[(r * s->size + c) * sectionSize + val] = add_column_header(table, name);
-            }
+    \return the number of bands, 1 to build it on the calling thread alone
+*/
+static unsigned no_build_bands(unsigned noCandidates, unsigned sectionSize) {
+    if(noCandidates < PARALLEL_BUILD_MIN_CANDIDATES) {
+        return 1;
+    }
+    long noCores = sysconf(_SC_NPROCESSORS_ONLN);
+    unsigned noBands = noCores < 1 ? 1 : noCores > MAX_BUILD_THREADS ? MAX_BUILD_THREADS : (unsigned) noCores;
+    return noBands < sectionSize ? noBands : sectionSize;
+}
+
+/*
+    Generates a constraint table from a given sudoku grid
+
+    This firstly counts the candidates of every row, so that all the nodes
+    can be allocated at once, then generates all the columns of the constraint
+    table and fills them with 1s by iterating through all the possible rows,
+    columns and, if the spaces is empty, values (which is equivalent to iterating
+    through all the rows of the exact cover matrix) and add in the necessary 1s.
+
+    Large tables are built by several threads: the rows are split into bands with about as many
+    candidates each, and since every band knows how many candidates come before it, it knows which
+    slice of the nodes is its own. Every band but the first chains the nodes it adds to a column
+    into a segment of its own, and the segments are then stitched into the columns in band order,
+    so the table is the same, node for node, as the one built by a single thread.
+
+    The columns are laid out as the row-column constraints, then the row-number,
+    column-number and box-number constraints, each ordered by section and value.
+
+    \param s the partially filled sudoku grid
+    \param allocator where to allocate the table
+
+    \return the generated constraint table, or NULL if the allocator failed
+*/
+static constraint_table *generate_table(const sudoku *s, const sudoku_allocator *allocator) {
+    const unsigned sectionSize = s->size * s->size;
+    const unsigned noCells = sectionSize * sectionSize;
+
+    // Collect the values already used in every row, column and box, so that a
+    // candidate can be checked without rescanning its sections.
+    const uint128_t ONE = 1;
+    uint128_t rowUsed[sectionSize];
+    uint128_t colUsed[sectionSize];
+    uint128_t boxUsed[sectionSize];
+    for(unsigned i = 0; i < sectionSize; ++i) {
+        rowUsed[i] = colUsed[i] = boxUsed[i] = 0;
+    }
+    for(unsigned row = 0; row < sectionSize; ++row) {
+        for(unsigned col = 0; col < sectionSize; ++col) {
+            int value = get_cell(s, row, col);
+            mark_used(&rowUsed[row], value);
+            mark_used(&colUsed[col], value);
+            mark_used(&boxUsed[(row / s->size) * s->size + col / s->size], value);
         }
     }
 
+    unsigned rowCandidates[sectionSize];
+    unsigned noCandidates = 0;
     for(unsigned row = 0; row < sectionSize; ++row) {
+        rowCandidates[row] = 0;
         for(unsigned col = 0; col < sectionSize; ++col) {
             if(get_cell(s, row, col) == 0) {
+                uint128_t used = rowUsed[row] | colUsed[col] | boxUsed[(row / s->size) * s->size + col / s->size];
                 for(unsigned val = 0; val < sectionSize; ++val) {
-                    set_cell(s, row, col, val+1);
-                    if(check_update(s, (position){row,col})) {
-                        column_object *rowColumnHeader = rowColumnHeaders[row * sectionSize + col];
-                        column_object *rowNumberHeader = rowNumberHeaders[row * sectionSize + val];
-                        column_object *colNumberHeader = columnNumberHeaders[col * sectionSize + val];
-                        unsigned boxRow = row / s->size;
-                        unsigned boxCol = col / s->size;
-                        column_object *boxNumberHeader = boxNumberHeaders[(boxRow * s->size + boxCol) * sectionSize + val];
-
-                        cell_object *rowColumnConstraint = add_constraint_to_column(rowColumnHeader, row, col, val);
-                        cell_object *rowNumberConstraint = add_constraint_to_column(rowNumberHeader, row, col, val);
-                        cell_object *colNumberConstraint = add_constraint_to_column(colNumberHeader, row, col, val);
-                        cell_object *boxNumberConstraint = add_constraint_to_column(boxNumberHeader, row, col, val);
-
-                        link_left_of(NULL, &rowColumnConstraint->links);
-                        link_left_of(&rowColumnConstraint->links, &rowNumberConstraint->links);
-                        link_left_of(&rowColumnConstraint->links, &colNumberConstraint->links);
-                        link_left_of(&rowColumnConstraint->links, &boxNumberConstraint->links);
-
+                    if((used & (ONE << (val + 1))) == 0) {
+                        rowCandidates[row]++;
                     }
-                    set_cell(s, row, col, 0);
                 }
             }
         }
+        noCandidates += rowCandidates[row];
+    }
+
+    constraint_table *table = allocate_with(allocator, sizeof(constraint_table));
+    if(table == NULL) {
+        return NULL;
+    }
+    table->allocator = allocator;
+    table->noColumns = 4 * noCells;
+    table->noNodes = 0;
+
+    const unsigned noNodes = 1 + table->noColumns + 4 * noCandidates;
+    table->links = allocate_with(allocator, sizeof(table_links) * noNodes);
+    table->sizes = allocate_with(allocator, sizeof(unsigned) * (1 + table->noColumns));
+    table->cells = allocate_with(allocator, sizeof(cell_object) * (noCandidates > 0 ? noCandidates : 1));
+    if(table->links == NULL || table->sizes == NULL || table->cells == NULL) {
+        free_constraint_table(table);
+        return NULL;
+    }
+
+    table_links *links = table->links;
+    node_index head = table->noNodes++;
+    links[head] = (table_links){head, head, head, head, head};
+
+    for(unsigned i = 0; i < table->noColumns; ++i) {
+        add_column_header(table);
+    }
+
+    // Split the rows into bands, and the columns evenly between them for the stitching.
+    const unsigned noBands = no_build_bands(noCandidates, sectionSize);
+    table_band bands[MAX_BUILD_THREADS];
+    unsigned row = 0;
+    unsigned candidate = 0;
+    bool segmentsAllocated = true;
+    for(unsigned i = 0; i < noBands; ++i) {
+        table_band *band = &bands[i];
+        band->table = table;
+        band->s = s;
+        band->rowUsed = rowUsed;
+        band->colUsed = colUsed;
+        band->boxUsed = boxUsed;
+        band->segments = i == 0 ? NULL : allocate_with(allocator, sizeof(column_segment) * (1 + table->noColumns));
+        segmentsAllocated = segmentsAllocated && (i == 0 || band->segments != NULL);
+        band->bands = bands;
+        band->noBands = noBands;
+        band->firstColumn = 1 + (unsigned long) table->noColumns * i / noBands;
+        band->lastColumn = 1 + (unsigned long) table->noColumns * (i + 1) / noBands;
+
+        band->firstRow = row;
+        band->firstCandidate = candidate;
+        const unsigned long target = (unsigned long) noCandidates * (i + 1) / noBands;
+        while(row < sectionSize && (candidate < target || i + 1 == noBands)) {
+            candidate += rowCandidates[row++];
+        }
+        band->lastRow = row;
+        band->lastCandidate = candidate;
+    }
+
+    if(!segmentsAllocated) {
+        for(unsigned i = 1; i < noBands; ++i) {
+            if(bands[i].segments != NULL) {
+                release_with(allocator, bands[i].segments);
+            }
+        }
+        free_constraint_table(table);
+        return NULL;
+    }
+
+    if(noBands == 1) {
+        build_band(&bands[0]);
+    }
+    else {
+        run_on_bands(build_band, bands, noBands);
+        run_on_bands(stitch_columns, bands, noBands);
+        for(unsigned i = 1; i < noBands; ++i) {
+            release_with(allocator, bands[i].segments);
+        }
     }
+    table->noNodes = noNodes;
 
+    TRACE_BEGIN("remove_zero_columns");
     remove_zero_columns(table);
+    TRACE_END("remove_zero_columns");
 
-    free(rowColumnHeaders);
-    free(rowNumberHeaders);
-    free(columnNumberHeaders);
-    free(boxNumberHeaders);
     return table;
 }
 
@@ -411,17 +621,21 @@ static constraint_table *generate_table(sudoku *s) {
     \param output an output stream to write to
 */
 static void write_table(constraint_table* table, FILE *output) {
-    column_object * current = (column_object*) table->head->right;
-    while((table_links*) current != table->head) {
-        fprintf(output, "%s(%d) :",current->name, current->size);
-
-        cell_object *currentVal = (cell_object*) current->links.down;
-        while((table_links*) currentVal != (table_links*)current) {
-            fprintf(output, "(R%d C%d #%d) ", currentVal->row + 1, currentVal->col + 1, currentVal->value + 1);
-            currentVal = (cell_object*) currentVal->links.down;
+    const table_links *links = table->links;
+    const unsigned noCells = table->noColumns / 4;
+
+    for(node_index current = links[TABLE_HEAD].right; current != TABLE_HEAD; current = links[current].right) {
+        // Column names follow the layout described in generate_table.
+        static const char *const KINDS[] = {"RC", "R#", "C#", "B#"};
+        unsigned kind = (current - 1) / noCells;
+        unsigned index = (current - 1) % noCells;
+        fprintf(output, "%s%u(%u) :", KINDS[kind], index, table->sizes[current]);
+
+        for(node_index currentVal = links[current].down; currentVal != current; currentVal = links[currentVal].down) {
+            const cell_object *cell = cell_of(table, currentVal);
+            fprintf(output, "(R%d C%d #%d) ", cell->row + 1, cell->col + 1, cell->value + 1);
         }
         fprintf(output, "\n");
-        current = (column_object*) current->links.right;
     }
 }
 
@@ -430,19 +644,22 @@ static void write_table(constraint_table* table, FILE *output) {
 
     \param table table to search for the column
 
-    \return the smallest column found
+    \return the header of the smallest column found
 */
-static column_object *get_smallest_column(constraint_table *table) {
-    column_object *current = (column_object*) table->head->right;
+static node_index get_smallest_column(const constraint_table *table) {
+    const table_links *links = table->links;
 
-    column_object *smallestColumn = NULL;
+    node_index smallestColumn = TABLE_HEAD;
     unsigned smallestSize = UINT_MAX;
-    while(current->links.right != table->head) {
-        if(current->size < smallestSize) {
-            smallestSize = current->size;
+    for(node_index current = links[TABLE_HEAD].right; current != TABLE_HEAD; current = links[current].right) {
+        if(table->sizes[current] < smallestSize) {
+            smallestSize = table->sizes[current];
             smallestColumn = current;
+            if(smallestSize <= 1) {
+                // Can't do better than a forced (or a dead) column.
+                break;
+            }
         }
-        current = (column_object*) current->links.right;
     }
 
     return smallestColumn;
@@ -451,61 +668,125 @@ static column_object *get_smallest_column(constraint_table *table) {
 /*
     Temporarily remove the given column from its coresponding constraint table
 
-    \param column the column to be removed
+    \param table the table the column is part of
+    \param column the header of the column to be removed
 
     \sa uncover_column
 */
-static void cover_column(column_object *column) {
-    cover_left_right((table_links*) column);
-
-    table_links* rowToCover = column->links.down;
-    while(rowToCover != (table_links*) column) {
-        cell_object* attachedCell = (cell_object*) rowToCover->right;
-        while((table_links*) attachedCell != rowToCover) {
-            cover_up_down(&attachedCell->links);
-            attachedCell->links.column->size--;
-            attachedCell = (cell_object*) attachedCell->links.right;
+static void cover_column(constraint_table *table, node_index column) {
+    table_links *links = table->links;
+    cover_left_right(links, column);
+
+    for(node_index rowToCover = links[column].down; rowToCover != column; rowToCover = links[rowToCover].down) {
+        for(node_index attachedCell = links[rowToCover].right; attachedCell != rowToCover; attachedCell = links[attachedCell].right) {
+            cover_up_down(links, attachedCell);
+            table->sizes[links[attachedCell].column]--;
         }
-        rowToCover = rowToCover->down;
     }
 }
 
 /*
     Restore a column that was removed with the cover_column function
 
-    \param column pointer to the header of the removed column
+    \param table the table the column is part of
+    \param column the header of the removed column
 
     \sa cover_column
 */
-static void uncover_column(column_object *column) {
-    table_links* rowToUncover = column->links.up;
-    while(rowToUncover != (table_links*) column) {
-        cell_object* attachedCell = (cell_object*) rowToUncover->left;
-        while((table_links*) attachedCell != rowToUncover) {
-            attachedCell->links.column->size ++;
-            uncover_up_down((table_links*) attachedCell);
-            attachedCell = (cell_object*) attachedCell->links.left;
+static void uncover_column(constraint_table *table, node_index column) {
+    table_links *links = table->links;
+
+    for(node_index rowToUncover = links[column].up; rowToUncover != column; rowToUncover = links[rowToUncover].up) {
+        for(node_index attachedCell = links[rowToUncover].left; attachedCell != rowToUncover; attachedCell = links[attachedCell].left) {
+            table->sizes[links[attachedCell].column]++;
+            uncover_up_down(links, attachedCell);
         }
-        rowToUncover = rowToUncover->up;
     }
-    uncover_left_right((table_links*) column);
+    uncover_left_right(links, column);
 }
 
 /*
-    Fills in a sudoku with a list of cell objects (which represents the row, column and values to be filled)
+    Fills in a sudoku with a list of matrix rows (which represents the row, column and values to be filled)
 
+    \param table the table the matrix rows are part of
     \param s the sudoku to be filled in
-    \param thingsToFill array of cell_objects that represents what rows and columns have to be filled with what values.
-    \param noThingsToFill the number of objects in the thingsToFill array.
+    \param solved where to write the filled in sudoku, of the same size as s
+    \param thingsToFill array of nodes, one from each matrix row that has to be filled in.
+    \param noThingsToFill the number of nodes in the thingsToFill array.
 */
-static sudoku * fill_in_sudoku(const sudoku *s, cell_object** thingsToFill, unsigned noThingsToFill) {
-    sudoku *solved = copy_sudoku(s);
+static void fill_in_sudoku(const constraint_table *table, const sudoku *s, sudoku *solved, const node_index* thingsToFill, unsigned noThingsToFill) {
+    memcpy(solved->cells, s->cells, sizeof(int) * get_no_cells(s));
 
     for(unsigned i = 0; i < noThingsToFill; ++i) {
-        set_cell(solved, thingsToFill[i]->row, thingsToFill[i]->col, thingsToFill[i]->value + 1);
+        const cell_object *cell = cell_of(table, thingsToFill[i]);
+        set_cell(solved, cell->row, cell->col, cell->value + 1);
     }
+}
+
+/*
+    Checks if the search went over its node budget, was cancelled or ran out of memory.
+
+    \param state the intermediary state of solving the sudoku
 
-    return solved;
+    \return true if the search should stop without a verdict
+*/
+static bool solve_aborted(const solve_state *state) {
+    return (state->maxNodes != 0 && state->noNodes >= state->maxNodes) || state->outOfMemory
+        || (state->cancel != NULL && __atomic_load_n(state->cancel, __ATOMIC_RELAXED) != 0);
+}
+
+/*
+    Saves the position of the search, about to visit a node, to the checkpoint file.
+
+    \param state the intermediary state of solving the sudoku
+    \param depth the depth of the node
+*/
+static void save_position(solve_state *state, unsigned depth) {
+    search_position position = {(sudoku *) state->current, state->noNodes, state->no_solutions, state->solution,
+                                depth, state->branches};
+    if(save_search_position(state->checkpoint->path, &position) != 0) {
+        state->checkpoint->status = -1;
+    }
+    else {
+        state->checkpoint->noSaved++;
+    }
+}
+
+/*
+    Saves the position of the search if it was asked for, about to visit a node.
+
+    \param state the intermediary state of solving the sudoku
+    \param depth the depth of the node
+*/
+static void save_position_if_requested(solve_state *state, unsigned depth) {
+    solve_checkpoint *checkpoint = state->checkpoint;
+    // On the way down to a resumed position, the path doesn't account for the skipped subtrees yet.
+    if(checkpoint != NULL && !state->resuming && __atomic_load_n(&checkpoint->requested, __ATOMIC_RELAXED)) {
+        save_position(state, depth);
+        __atomic_store_n(&checkpoint->requested, 0, __ATOMIC_RELAXED);
+    }
+}
+
+/*
+    Checks if the search should stop before visiting a node, saving the position of that node
+    first if it was asked for.
+
+    A signal stopping the search asks for a save before cancelling it, so a search seen cancelled
+    always has the save pending. It's made here, before the search unwinds and the parents move
+    on to their next branch, which would mark the node as explored.
+
+    \param state the intermediary state of solving the sudoku
+    \param depth the depth of the node
+
+    \return true if the search should stop without visiting the node
+*/
+static bool stop_before(solve_state *state, unsigned depth) {
+    if(solve_aborted(state)) {
+        save_position_if_requested(state, depth);
+        return true;
+    }
+    save_position_if_requested(state, depth);
+    return false;
 }
 
 /*
@@ -519,82 +800,171 @@ static sudoku * fill_in_sudoku(const sudoku *s, cell_object** thingsToFill, unsi
     \param depth the recursion depth of the algorithm
 */
 static void solve_table(constraint_table *table, solve_state* state, unsigned depth) {
-    if(state->no_solutions < 2) {
-        table_links* head = table->head;
-
-        if(head->right == head) {
-            state->no_solutions++;
-            if(state->no_solutions == 1) {
-                assert(state->solution == NULL);
-                state->solution = fill_in_sudoku(state->current, state->solutionObjects, depth);
+    solve_checkpoint *checkpoint = state->checkpoint;
+    if(checkpoint != NULL && state->resuming && depth == checkpoint->resume->depth) {
+        state->resuming = false;
+    }
+
+    if(state->no_solutions < state->maxSolutions && !stop_before(state, depth)) {
+        const table_links *links = table->links;
+        if(!state->resuming) {
+            state->noNodes++; // The nodes on the way down to a resumed position were counted before.
+        }
+
+        solve_progress *progress = state->progress;
+        if(progress != NULL) {
+            __atomic_store_n(&progress->noNodes, state->noNodes, __ATOMIC_RELAXED);
+            __atomic_store_n(&progress->depth, depth, __ATOMIC_RELAXED);
+        }
+
+        if(links[TABLE_HEAD].right == TABLE_HEAD) {
+            // The second solution overwrites the first.
+            if(state->solution == NULL) {
+                state->solution = state->destination != NULL ? state->destination
+                                : create_sudoku_with(state->allocator, state->current->size);
+                state->outOfMemory = state->solution == NULL;
             }
-            else {
-                assert(state->solution != NULL);
-                free_sudoku(state->solution);
-                state->solution = fill_in_sudoku(state->current, state->solutionObjects, depth);
+            if(state->solution != NULL) {
+                state->no_solutions++;
+                fill_in_sudoku(table, state->current, state->solution, state->solutionObjects, depth);
             }
         }
         else {
             // Choose a column header.
-            column_object* smallestColumn = get_smallest_column(table);
+            node_index smallestColumn = get_smallest_column(table);
 
-            // Cover column
-            cover_column(smallestColumn);
-            table_links* rowToCover = smallestColumn->links.down;
+            // Only the top of the tree is published, which is enough to estimate the progress.
+            bool publish = progress != NULL && depth < PROGRESS_LEVELS;
+            if(publish) {
+                __atomic_store_n(&progress->noBranches[depth], table->sizes[smallestColumn], __ATOMIC_RELAXED);
+            }
 
-            while(rowToCover != (table_links*) smallestColumn) {
-                state->solutionObjects[depth] = (cell_object*) rowToCover;
+            // Cover column
+            cover_column(table, smallestColumn);
+
+            // The rows of a column are ordered by value, so walking them upwards tries the largest first.
+            node_index rowToCover = state->descending ? links[smallestColumn].up : links[smallestColumn].down;
+            // Once the search is over, the remaining rows would only be covered to be uncovered again.
+            for(unsigned branch = 0; rowToCover != smallestColumn && state->no_solutions < state->maxSolutions; ++branch) {
+                if(state->resuming && branch < checkpoint->resume->branches[depth]) {
+                    // Explored before the position was saved.
+                    rowToCover = state->descending ? links[rowToCover].up : links[rowToCover].down;
+                    continue;
+                }
+                state->branches[depth] = branch;
+                if(stop_before(state, depth + 1)) {
+                    break;
+                }
+                state->solutionObjects[depth] = rowToCover;
+                if(publish) {
+                    __atomic_store_n(&progress->branch[depth], branch, __ATOMIC_RELAXED);
+                }
 
-                cell_object* attachedCell = (cell_object*) rowToCover->right;
-                while((table_links*) attachedCell != rowToCover) {
+                for(node_index attachedCell = links[rowToCover].right; attachedCell != rowToCover; attachedCell = links[attachedCell].right) {
                     // Cover column for attachedCell
-                    cover_column(attachedCell->links.column);
-                    attachedCell = (cell_object*) attachedCell->links.right;
+                    cover_column(table, links[attachedCell].column);
                 }
                 solve_table(table, state, depth + 1);
-                rowToCover = (table_links*) state->solutionObjects[depth];
 
-                attachedCell = (cell_object*) rowToCover->left;
-                while((table_links*) attachedCell != rowToCover) {
+                for(node_index attachedCell = links[rowToCover].left; attachedCell != rowToCover; attachedCell = links[attachedCell].left) {
                     // Uncover column for attachedCell
-                    uncover_column(attachedCell->links.column);
-                    attachedCell = (cell_object*) attachedCell->links.left;
+                    uncover_column(table, links[attachedCell].column);
                 }
-                rowToCover = rowToCover->down;
+                rowToCover = state->descending ? links[rowToCover].up : links[rowToCover].down;
             }
+            // Only a damaged position file can leave a branch to resume from past the last row.
+            state->resuming = false;
+
             // Uncover column
-            uncover_column(smallestColumn);
+            uncover_column(table, smallestColumn);
         }
     }
 }
 
 /*
-    Solves the given sudoku, abiding to the interface defined in sudoku_solve.h
+    Solves the given sudoku with dancing links, allocating all memory through the given allocator.
 
+    \param allocator where to allocate the table and the solution, or NULL for malloc
     \param input the sudoku to be solved
+    \param options the node budget, value order, cancellation flag, progress, checkpoint and counters of
+           the search
+    \param destination where to write the solution, or NULL to allocate it through the allocator
 
-    \returns a solve result object which contains the solving status and a solution, if found
+    \returns a solve result object which contains the solving status and a solution, if found, or
+             SR_NO_MEMORY without a solution if the allocator failed
 */
-solve_result solve_sudoku(const sudoku *input) {
-
-    sudoku *toSolve = copy_sudoku(input);
+static solve_result solve_dlx(const sudoku_allocator *allocator, const sudoku *input, const solve_options *options,
+                              sudoku *destination) {
+    solve_counters *counters = options->counters;
+    uint64_t countsBefore[NO_HARDWARE_COUNTERS];
+    if(counters != NULL) {
+        read_solve_counters(counters, countsBefore);
+    }
+    TRACE_BEGIN("generate_table");
+    constraint_table *table = generate_table(input, allocator);
+    TRACE_END("generate_table");
+    if(counters != NULL) {
+        add_solve_counts(counters, countsBefore, counters->table);
+    }
 
-    constraint_table *table = generate_table(toSolve);
+    if(table == NULL) {
+        return (solve_result){SR_NO_MEMORY, NULL};
+    }
 
-    cell_object** solutionObjects = malloc(sizeof(cell_object*) * no_empty_spaces(input)); // Compute the number by counting the number of zeros.
-    assert(solutionObjects);
+    node_index* solutionObjects = allocate_with(allocator, sizeof(node_index) * no_empty_spaces(input)); // Compute the number by counting the number of zeros.
+    unsigned *branches = allocate_with(allocator, sizeof(unsigned) * no_empty_spaces(input));
+    if(solutionObjects == NULL || branches == NULL) {
+        if(solutionObjects != NULL) {
+            release_with(allocator, solutionObjects);
+        }
+        if(branches != NULL) {
+            release_with(allocator, branches);
+        }
+        free_constraint_table(table);
+        return (solve_result){SR_NO_MEMORY, NULL};
+    }
 
-    solve_state state = (solve_state){0,toSolve,solutionObjects, NULL};
+    solve_state state = (solve_state){0,input,solutionObjects, branches, NULL, destination, 0, options->maxNodes, options->descending,
+                                      options->firstSolution ? 1 : 2, options->cancel, options->progress, options->checkpoint, false, allocator,
+                                      false};
+    const search_position *resume = options->checkpoint != NULL ? options->checkpoint->resume : NULL;
+    if(resume != NULL) {
+        assert(resume->puzzle->size == input->size && resume->depth <= no_empty_spaces(input));
+        state.noNodes = resume->noNodes;
+        state.no_solutions = resume->noSolutions;
+        if(resume->solution != NULL) {
+            state.solution = destination != NULL ? destination : create_sudoku_with(allocator, input->size);
+            state.outOfMemory = state.solution == NULL;
+            if(state.solution != NULL) {
+                memcpy(state.solution->cells, resume->solution->cells, sizeof(int) * get_no_cells(input));
+            }
+        }
+        state.resuming = true;
+    }
+    if(options->progress != NULL) {
+        options->progress->maxDepth = no_empty_spaces(input);
+    }
+    if(counters != NULL) {
+        read_solve_counters(counters, countsBefore);
+    }
+    TRACE_BEGIN("solve_table");
     solve_table(table, &state, 0);
+    TRACE_END("solve_table");
+    if(counters != NULL) {
+        add_solve_counts(counters, countsBefore, counters->search);
+    }
 
     solve_result result;
 
     switch (state.no_solutions) {
         case 0:
-            result.status = SR_UNSOLVABLE;
+            result.status = solve_aborted(&state) ? SR_ABORTED : SR_UNSOLVABLE;
+            result.solution = NULL;
             break;
         case 1:
-            result.status = SR_SOLVED;
+            // A single solution is only known to be unique if the search was not cut short, or stopped
+            // right after it.
+            result.status = solve_aborted(&state) || state.maxSolutions == 1 ? SR_ABORTED : SR_SOLVED;
             result.solution = state.solution;
             break;
         default:
@@ -602,10 +972,139 @@ solve_result solve_sudoku(const sudoku *input) {
             result.solution = state.solution;
             break;
     }
+    if(state.outOfMemory) {
+        // Only the first solution is allocated, so there is none to return.
+        result.status = SR_NO_MEMORY;
+        result.solution = NULL;
+    }
 
-    free_sudoku(toSolve);
-    free(solutionObjects);
+    release_with(allocator, solutionObjects);
+    release_with(allocator, branches);
+
+    if(options->noNodes != NULL) {
+        *options->noNodes = state.noNodes;
+    }
     free_constraint_table(table);
 
     return result;
 }
+
+/*
+    Solves the given sudoku with dancing links, allocating all memory through the given allocator.
+
+    \param allocator where to allocate the table and the solution, or NULL for malloc
+    \param input the sudoku to be solved
+    \param options the node budget, value order, cancellation flag, progress, checkpoint and counters of
+           the search
+
+    \returns a solve result object which contains the solving status and a solution, if found
+*/
+solve_result solve_sudoku_dlx(const sudoku_allocator *allocator, const sudoku *input, const solve_options *options) {
+    return solve_dlx(allocator, input, options, NULL);
+}
+
+#ifndef SUDOKU_ENGINE_ONLY
+
+/*
+    Computes how much memory solve_dlx allocates at most for the sudokus of a given size: the
+    table, with a row for every value of every cell and the column segments of the threads building
+    it, and the path of the search.
+
+    \param size the size of the sudokus
+
+    \return the number of bytes, counting the rounding of every block by the arena
+*/
+size_t solve_scratch_size(unsigned size) {
+    const size_t sectionSize = size * size;
+    const size_t noCells = sectionSize * sectionSize;
+    const size_t noColumns = 4 * noCells;
+    const size_t maxCandidates = noCells * sectionSize;
+
+    const size_t blocks[] = {
+        sizeof(constraint_table),
+        sizeof(table_links) * (1 + noColumns + 4 * maxCandidates),
+        sizeof(unsigned) * (1 + noColumns),
+        sizeof(cell_object) * maxCandidates,
+        sizeof(node_index) * noCells,
+        sizeof(unsigned) * noCells
+    };
+    size_t total = 0;
+    for(unsigned i = 0; i < sizeof(blocks) / sizeof(blocks[0]); ++i) {
+        total += (blocks[i] + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT * ARENA_ALIGNMENT;
+    }
+    if(maxCandidates >= PARALLEL_BUILD_MIN_CANDIDATES) {
+        // The column segments of every band built by a thread of its own.
+        const size_t segments = sizeof(column_segment) * (1 + noColumns);
+        total += (MAX_BUILD_THREADS - 1) * ((segments + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT * ARENA_ALIGNMENT);
+    }
+    return total;
+}
+
+/*
+    Solves the given sudoku into a sudoku and with scratch memory owned by the caller, abiding to
+    the interface defined in sudoku_solve.h
+
+    \param input the sudoku to be solved
+    \param solution where to write the solution
+    \param scratch the working memory, of at least solve_scratch_size bytes
+    \param scratchSize the size of the working memory
+    \param maxNodes the node budget of the search, or 0 for an unbounded search
+
+    \returns the solving status
+*/
+solve_status solve_sudoku_into(const sudoku *input, sudoku *solution, void *scratch, size_t scratchSize,
+                               unsigned long maxNodes) {
+    assert(solution->size == input->size);
+    solve_options options = {maxNodes, false, NULL, NULL, NULL, NULL, NULL, false};
+    if(input->size == 3) {
+        // Classic sudokus have an engine of their own, which needs no table and no scratch memory.
+        return solve_sudoku_9x9_into(input, solution, &options);
+    }
+    sudoku_arena arena = {scratch, scratchSize, 0};
+    const sudoku_allocator allocator = arena_allocator(&arena);
+    return solve_dlx(&allocator, input, &options, solution).status;
+}
+
+/*
+    Solves the given sudoku, allocating all memory through the given allocator and giving up after
+    visiting a given number of search nodes.
+
+    \param allocator where to allocate the table and the solution, or NULL for malloc
+    \param input the sudoku to be solved
+    \param maxNodes the node budget of the search, or 0 for an unbounded search
+
+    \returns a solve result object which contains the solving status and a solution, if found
+*/
+solve_result solve_sudoku_with(const sudoku_allocator *allocator, const sudoku *input, unsigned long maxNodes) {
+    solve_options options = {maxNodes, false, NULL, NULL, NULL, NULL, NULL, false};
+    if(input->size == 3) {
+        // Classic sudokus have an engine of their own, which needs no table.
+        return solve_sudoku_9x9(allocator, input, &options);
+    }
+    return solve_sudoku_dlx(allocator, input, &options);
+}
+
+/*
+    Solves the given sudoku, abiding to the interface defined in sudoku_solve.h
+
+    \param input the sudoku to be solved
+
+    \returns a solve result object which contains the solving status and a solution, if found
+*/
+solve_result solve_sudoku(const sudoku *input) {
+    return solve_sudoku_with(NULL, input, 0);
+}
+
+/*
+    Solves the given sudoku, giving up after visiting a given number of search nodes.
+
+    \param input the sudoku to be solved
+    \param maxNodes the node budget of the search, or 0 for an unbounded search
+
+    \returns a solve result object which contains the solving status and a solution, if found
+*/
+solve_result solve_sudoku_bounded(const sudoku *input, unsigned long maxNodes) {
+    return solve_sudoku_with(NULL, input, maxNodes);
+}
+
+#endif /* SUDOKU_ENGINE_ONLY */
@@ -0,0 +1,448 @@
+#include "sudoku_portfolio.h"
+#include "sudoku_trace.h"
+#include <assert.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+/*
+    Algorithm X on dense bitsets, for the sudokus of size BITSET_MAX_SIZE or less.
+
+    The exact cover matrix is the one dancing links uses (see generate_table): a row for every
+    candidate, and the cell, row-number, column-number and box-number constraint columns, each
+    ordered by section and value. A column of a sudoku with at most 32 values has at most 32 rows,
+    told apart by a single index: the value for a cell column, the column of the cell for a
+    row-number one, its row for a column-number one and its position in the box for a box-number
+    one. So every column is kept as a 32-bit mask of the rows still in it, and the columns left to
+    cover as a bitset. Removing a row clears one bit in each of its four columns, the size of a
+    column is a popcount, and instead of relinking nodes on the way back, the removed rows are
+    pushed on a trail and their bits set again. The whole matrix of a 25x25 sudoku takes 10 kB,
+    where the linked table takes half a megabyte.
+
+    The smallest column and the rows of a column are taken in the same order as in the dancing
+    links search, so on any sudoku without a dead column from the start, both engines walk the
+    same search tree.
+*/
+
+/*
+    A row of the matrix: the cell shifted left by 5 bits, ORed with the value (from 0).
+*/
+typedef uint16_t matrix_row;
+
+// The shift of the cell in a matrix_row.
+#define ROW_CELL_SHIFT 5
+
+typedef struct {
+    unsigned size;
+    unsigned sectionSize; //< the number of values
+    unsigned noCells;
+    uint32_t *columns; //< the rows still in every column, laid out like the dancing links headers
+    unsigned char *sizes; //< the number of rows still in every column
+    uint64_t *active; //< the columns left to cover, one bit each
+    unsigned noActiveWords;
+    matrix_row *trail; //< the rows removed so far, in order
+    unsigned trailSize;
+    matrix_row *chosen; //< the row chosen at every depth
+    unsigned char *cellRow; //< the row of every cell
+    unsigned char *cellCol; //< the column of every cell
+    unsigned char *cellBox; //< the box of every cell
+    unsigned char *cellPos; //< the position of every cell in its box
+    uint16_t *cellColumns; //< the row-number, column-number and box-number columns of every cell, for value 0
+    matrix_row *columnBase; //< the matrix row at index 0 of every column
+    unsigned char *columnKind; //< the kind of every column: 0 for cell, 1 for row-number, 2 for
+                               //  column-number and 3 for box-number
+    matrix_row rowOffsets[4][32]; //< what to add to the base of a column of every kind to get the
+                                  //  matrix row at every index
+    int no_solutions; //< number of solutions found
+    const sudoku *current; //< the sudoku we're trying to solve
+    sudoku *solution; //< the last solution found
+    unsigned long noNodes; //< number of search nodes visited so far
+    unsigned long maxNodes; //< give up after visiting this many nodes (0 for no limit)
+    bool descending; //< take the rows of a column from the largest index down
+    int maxSolutions; //< stop once this many solutions are found: 1, or 2 to tell whether there is a single one
+    const int *cancel; //< give up once this becomes non-zero (NULL for never)
+    const sudoku_allocator *allocator; //< where the solution is allocated
+    bool outOfMemory; //< set if the solution couldn't be allocated, which stops the search
+} bitset_state;
+
+/*
+    Finds the four columns of a matrix row.
+
+    \param state the state of the search
+    \param row the matrix row
+    \param columns filled in with the cell, row-number, column-number and box-number columns
+*/
+static void columns_of(const bitset_state *state, matrix_row row, unsigned columns[4]) {
+    const unsigned cell = row >> ROW_CELL_SHIFT;
+    const unsigned value = row & ((1u << ROW_CELL_SHIFT) - 1);
+    columns[0] = cell;
+    columns[1] = state->cellColumns[3 * cell] + value;
+    columns[2] = state->cellColumns[3 * cell + 1] + value;
+    columns[3] = state->cellColumns[3 * cell + 2] + value;
+}
+
+/*
+    Removes a row from its four columns, and pushes it on the trail.
+
+    \param state the state of the search
+    \param row the matrix row to remove
+*/
+static void remove_row(bitset_state *state, matrix_row row) {
+    const unsigned cell = row >> ROW_CELL_SHIFT;
+    const unsigned value = row & ((1u << ROW_CELL_SHIFT) - 1);
+    unsigned columns[4];
+    columns_of(state, row, columns);
+
+    state->columns[columns[0]] &= ~(UINT32_C(1) << value);
+    state->columns[columns[1]] &= ~(UINT32_C(1) << state->cellCol[cell]);
+    state->columns[columns[2]] &= ~(UINT32_C(1) << state->cellRow[cell]);
+    state->columns[columns[3]] &= ~(UINT32_C(1) << state->cellPos[cell]);
+    for(unsigned i = 0; i < 4; ++i) {
+        state->sizes[columns[i]]--;
+    }
+    state->trail[state->trailSize++] = row;
+}
+
+/*
+    Puts back every row removed since the trail had a given size, most recent first.
+
+    \param state the state of the search
+    \param trailSize the size of the trail to go back to
+*/
+static void restore_rows(bitset_state *state, unsigned trailSize) {
+    while(state->trailSize > trailSize) {
+        const matrix_row row = state->trail[--state->trailSize];
+        const unsigned cell = row >> ROW_CELL_SHIFT;
+        const unsigned value = row & ((1u << ROW_CELL_SHIFT) - 1);
+        unsigned columns[4];
+        columns_of(state, row, columns);
+
+        state->columns[columns[0]] |= UINT32_C(1) << value;
+        state->columns[columns[1]] |= UINT32_C(1) << state->cellCol[cell];
+        state->columns[columns[2]] |= UINT32_C(1) << state->cellRow[cell];
+        state->columns[columns[3]] |= UINT32_C(1) << state->cellPos[cell];
+        for(unsigned i = 0; i < 4; ++i) {
+            state->sizes[columns[i]]++;
+        }
+    }
+}
+
+/*
+    Finds the matrix row at a given index of a column.
+
+    \param state the state of the search
+    \param column the column
+    \param index the index of the row in the column (a bit of its mask)
+
+    \return the matrix row
+*/
+static matrix_row row_of(const bitset_state *state, unsigned column, unsigned index) {
+    return state->columnBase[column] + state->rowOffsets[state->columnKind[column]][index];
+}
+
+/*
+    Covers a column: takes it out of the columns left to cover and removes all of its rows.
+
+    \param state the state of the search
+    \param column the column to cover
+*/
+static void cover(bitset_state *state, unsigned column) {
+    state->active[column / 64] &= ~(UINT64_C(1) << (column % 64));
+    for(uint32_t rows = state->columns[column]; rows != 0; rows &= rows - 1) {
+        remove_row(state, row_of(state, column, __builtin_ctz(rows)));
+    }
+}
+
+/*
+    Finds the column left to cover with the fewest rows, the first one of them in column order.
+
+    \param state the state of the search
+
+    \return the column, or -1 if every column is covered
+*/
+static int smallest_column(const bitset_state *state) {
+    int smallestColumn = -1;
+    unsigned smallestSize = UINT32_MAX;
+    for(unsigned word = 0; word < state->noActiveWords; ++word) {
+        for(uint64_t bits = state->active[word]; bits != 0; bits &= bits - 1) {
+            const unsigned column = word * 64 + __builtin_ctzll(bits);
+            const unsigned size = state->sizes[column];
+            if(size < smallestSize) {
+                smallestSize = size;
+                smallestColumn = (int) column;
+                if(size <= 1) {
+                    // Can't do better than a forced (or a dead) column.
+                    return smallestColumn;
+                }
+            }
+        }
+    }
+    return smallestColumn;
+}
+
+/*
+    Checks if the search went over its node budget, was cancelled or ran out of memory.
+
+    \param state the state of the search
+
+    \return true if the search should stop without a verdict
+*/
+static bool solve_aborted(const bitset_state *state) {
+    return (state->maxNodes != 0 && state->noNodes >= state->maxNodes) || state->outOfMemory
+        || (state->cancel != NULL && __atomic_load_n(state->cancel, __ATOMIC_RELAXED) != 0);
+}
+
+/*
+    Searches for the exact covers of the columns left, stopping at the second one.
+
+    \param state the state of the search
+    \param depth the number of rows chosen so far
+*/
+static void search(bitset_state *state, unsigned depth) {
+    if(state->no_solutions < state->maxSolutions && !solve_aborted(state)) {
+        state->noNodes++;
+
+        const int column = smallest_column(state);
+        if(column < 0) {
+            // The second solution overwrites the first.
+            if(state->solution == NULL) {
+                state->solution = create_sudoku_with(state->allocator, state->size);
+                if(state->solution == NULL) {
+                    state->outOfMemory = true;
+                    return;
+                }
+            }
+            state->no_solutions++;
+            memcpy(state->solution->cells, state->current->cells, sizeof(int) * state->noCells);
+            for(unsigned i = 0; i < depth; ++i) {
+                const unsigned cell = state->chosen[i] >> ROW_CELL_SHIFT;
+                const int value = (state->chosen[i] & ((1u << ROW_CELL_SHIFT) - 1)) + 1;
+                set_cell(state->solution, state->cellRow[cell], state->cellCol[cell], value);
+            }
+            return;
+        }
+
+        const unsigned trailSize = state->trailSize;
+        uint32_t rows = state->columns[column];
+        while(rows != 0 && state->no_solutions < state->maxSolutions && !solve_aborted(state)) {
+            const unsigned index = state->descending ? 31 - (unsigned) __builtin_clz(rows) : (unsigned) __builtin_ctz(rows);
+            rows &= ~(UINT32_C(1) << index);
+
+            const matrix_row row = row_of(state, column, index);
+            unsigned columns[4];
+            columns_of(state, row, columns);
+            state->chosen[depth] = row;
+
+            for(unsigned i = 0; i < 4; ++i) {
+                cover(state, columns[i]);
+            }
+            search(state, depth + 1);
+            for(unsigned i = 0; i < 4; ++i) {
+                state->active[columns[i] / 64] |= UINT64_C(1) << (columns[i] % 64);
+            }
+            restore_rows(state, trailSize);
+        }
+    }
+}
+
+/*
+    Fills in the matrix of a sudoku: the rows of the candidates of its empty cells, and the
+    columns not satisfied by its givens.
+
+    \param state the state of the search, with its arrays allocated
+
+    \return false if the givens break a rule or hold a value out of range
+*/
+static bool fill_matrix(bitset_state *state) {
+    const unsigned size = state->size;
+    const unsigned sectionSize = state->sectionSize;
+    const sudoku *s = state->current;
+
+    const unsigned noCells = state->noCells;
+    for(unsigned row = 0; row < sectionSize; ++row) {
+        for(unsigned col = 0; col < sectionSize; ++col) {
+            const unsigned cell = row * sectionSize + col;
+            const unsigned box = (row / size) * size + col / size;
+            state->cellRow[cell] = row;
+            state->cellCol[cell] = col;
+            state->cellBox[cell] = box;
+            state->cellPos[cell] = (row % size) * size + col % size;
+            state->cellColumns[3 * cell] = noCells + row * sectionSize;
+            state->cellColumns[3 * cell + 1] = 2 * noCells + col * sectionSize;
+            state->cellColumns[3 * cell + 2] = 3 * noCells + box * sectionSize;
+        }
+    }
+    for(unsigned index = 0; index < sectionSize; ++index) {
+        state->rowOffsets[0][index] = index;
+        state->rowOffsets[1][index] = index << ROW_CELL_SHIFT;
+        state->rowOffsets[2][index] = (index * sectionSize) << ROW_CELL_SHIFT;
+        state->rowOffsets[3][index] = ((index / size) * sectionSize + index % size) << ROW_CELL_SHIFT;
+    }
+    for(unsigned kind = 0; kind < 4; ++kind) {
+        for(unsigned section = 0; section < sectionSize; ++section) {
+            // The cell at index 0 of the columns of the section.
+            const unsigned cells[4] = {
+                section * sectionSize,
+                section * sectionSize,
+                section,
+                (section / size) * size * sectionSize + (section % size) * size
+            };
+            for(unsigned value = 0; value < sectionSize; ++value) {
+                const unsigned column = kind * noCells + section * sectionSize + value;
+                state->columnKind[column] = kind;
+                // A cell column stands for a cell and holds its values, the others for a value.
+                state->columnBase[column] = kind == 0 ? (matrix_row) ((cells[kind] + value) << ROW_CELL_SHIFT)
+                                          : (matrix_row) (cells[kind] << ROW_CELL_SHIFT | value);
+            }
+        }
+    }
+
+    // Collect the values used in every row, column and box, so that only the candidates are added.
+    uint32_t rowUsed[sectionSize];
+    uint32_t colUsed[sectionSize];
+    uint32_t boxUsed[sectionSize];
+    memset(rowUsed, 0, sizeof(rowUsed));
+    memset(colUsed, 0, sizeof(colUsed));
+    memset(boxUsed, 0, sizeof(boxUsed));
+    for(unsigned cell = 0; cell < noCells; ++cell) {
+        const int value = s->cells[cell];
+        if(value < 0 || value > (int) sectionSize) {
+            return false;
+        }
+        if(value != 0) {
+            const uint32_t bit = UINT32_C(1) << (value - 1);
+            const unsigned box = state->cellBox[cell];
+            if(((rowUsed[state->cellRow[cell]] | colUsed[state->cellCol[cell]] | boxUsed[box]) & bit) != 0) {
+                // Two givens satisfy the same constraint.
+                return false;
+            }
+            rowUsed[state->cellRow[cell]] |= bit;
+            colUsed[state->cellCol[cell]] |= bit;
+            boxUsed[box] |= bit;
+        }
+    }
+
+    // Every column starts active, but the ones satisfied by a given, which have no rows.
+    const unsigned noColumns = 4 * noCells;
+    memset(state->active, 0xff, sizeof(uint64_t) * state->noActiveWords);
+    if(noColumns % 64 != 0) {
+        state->active[noColumns / 64] = (UINT64_C(1) << (noColumns % 64)) - 1;
+    }
+    memset(state->columns, 0, sizeof(uint32_t) * noColumns);
+    memset(state->sizes, 0, noColumns);
+    for(unsigned cell = 0; cell < noCells; ++cell) {
+        unsigned columns[4];
+        if(s->cells[cell] != 0) {
+            columns_of(state, (matrix_row) (cell << ROW_CELL_SHIFT | (s->cells[cell] - 1)), columns);
+            for(unsigned i = 0; i < 4; ++i) {
+                state->active[columns[i] / 64] &= ~(UINT64_C(1) << (columns[i] % 64));
+            }
+            continue;
+        }
+
+        const unsigned box = state->cellBox[cell];
+        uint32_t candidates = ~(rowUsed[state->cellRow[cell]] | colUsed[state->cellCol[cell]] | boxUsed[box])
+                            & (uint32_t) ((UINT64_C(1) << sectionSize) - 1);
+        for(; candidates != 0; candidates &= candidates - 1) {
+            const unsigned value = __builtin_ctz(candidates);
+            columns_of(state, (matrix_row) (cell << ROW_CELL_SHIFT | value), columns);
+            state->columns[columns[0]] |= UINT32_C(1) << value;
+            state->columns[columns[1]] |= UINT32_C(1) << state->cellCol[cell];
+            state->columns[columns[2]] |= UINT32_C(1) << state->cellRow[cell];
+            state->columns[columns[3]] |= UINT32_C(1) << state->cellPos[cell];
+            for(unsigned i = 0; i < 4; ++i) {
+                state->sizes[columns[i]]++;
+            }
+        }
+    }
+    return true;
+}
+
+/*
+    Solves a sudoku with Algorithm X on bitsets, allocating all memory through the given allocator.
+    Sudokus larger than BITSET_MAX_SIZE are handed to dancing links.
+
+    \param allocator where to allocate the matrix and the solution, or NULL for malloc
+    \param input the sudoku to be solved
+    \param options the node budget, value order and cancellation flag of the search
+
+    \returns a solve result object which contains the solving status and a solution, if found, or
+             SR_NO_MEMORY without a solution if the allocator failed
+*/
+solve_result solve_sudoku_bitset(const sudoku_allocator *allocator, const sudoku *input, const solve_options *options) {
+    if(input->size > BITSET_MAX_SIZE) {
+        return solve_sudoku_dlx(allocator, input, options);
+    }
+
+    bitset_state state;
+    state.size = input->size;
+    state.sectionSize = input->size * input->size;
+    state.noCells = get_no_cells(input);
+    state.noActiveWords = (4 * state.noCells + 63) / 64;
+    state.columns = allocate_with(allocator, sizeof(uint32_t) * 4 * state.noCells);
+    state.sizes = allocate_with(allocator, 4 * state.noCells);
+    state.active = allocate_with(allocator, sizeof(uint64_t) * state.noActiveWords);
+    state.trail = allocate_with(allocator, sizeof(matrix_row) * state.noCells * state.sectionSize);
+    state.trailSize = 0;
+    state.chosen = allocate_with(allocator, sizeof(matrix_row) * state.noCells);
+    state.cellRow = allocate_with(allocator, 4 * state.noCells);
+    state.cellCol = state.cellRow + state.noCells;
+    state.cellBox = state.cellCol + state.noCells;
+    state.cellPos = state.cellBox + state.noCells;
+    state.cellColumns = allocate_with(allocator, sizeof(uint16_t) * 3 * state.noCells);
+    state.columnBase = allocate_with(allocator, sizeof(matrix_row) * 4 * state.noCells);
+    state.columnKind = allocate_with(allocator, 4 * state.noCells);
+    state.no_solutions = 0;
+    state.current = input;
+    state.solution = NULL;
+    state.noNodes = 0;
+    state.maxNodes = options->maxNodes;
+    state.descending = options->descending;
+    state.maxSolutions = options->firstSolution ? 1 : 2;
+    state.cancel = options->cancel;
+    state.allocator = allocator;
+    // Failing allocations stop the search before it starts, and are released with the others.
+    state.outOfMemory = state.columns == NULL || state.sizes == NULL || state.active == NULL || state.trail == NULL
+        || state.chosen == NULL || state.cellRow == NULL || state.cellColumns == NULL || state.columnBase == NULL
+        || state.columnKind == NULL;
+
+    TRACE_BEGIN("solve_bitset");
+    if(!state.outOfMemory && fill_matrix(&state)) {
+        search(&state, 0);
+    }
+    TRACE_END("solve_bitset");
+
+    solve_result result;
+    switch (state.no_solutions) {
+        case 0:
+            result.status = solve_aborted(&state) ? SR_ABORTED : SR_UNSOLVABLE;
+            break;
+        case 1:
+            // A single solution is only known to be unique if the search was not cut short, or stopped
+            // right after it.
+            result.status = solve_aborted(&state) || state.maxSolutions == 1 ? SR_ABORTED : SR_SOLVED;
+            break;
+        default:
+            result.status = SR_MULTIPLE;
+            break;
+    }
+    result.solution = state.solution;
+    if(state.outOfMemory) {
+        // Only the first solution is allocated, so there is none to return.
+        result.status = SR_NO_MEMORY;
+    }
+
+    void *blocks[] = {state.columns, state.sizes, state.active, state.trail, state.chosen, state.cellRow,
+                      state.cellColumns, state.columnBase, state.columnKind};
+    for(unsigned i = 0; i < sizeof(blocks) / sizeof(blocks[0]); ++i) {
+        if(blocks[i] != NULL) {
+            release_with(allocator, blocks[i]);
+        }
+    }
+
+    if(options->noNodes != NULL) {
+        *options->noNodes = state.noNodes;
+    }
+
+    return result;
+}
@@ -1,37 +1,463 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include "sudoku_io.h"
 #include "sudoku_solve.h"
 #include "sudoku_checking.h"
+#include "sudoku_canon.h"
+#include "sudoku_count.h"
+#include "sudoku_hardness.h"
+#include "sudoku_portfolio.h"
+#include "sudoku_pipeline.h"
+#include "sudoku_progress.h"
+#include "sudoku_trace.h"
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <sys/time.h>
+
+// Maximum number of results kept by --cache.
+static const unsigned CACHE_CAPACITY = 100000;
+
+// Number of sudokus --threads may have read ahead of the output, per worker.
+static const unsigned WINDOW_PER_WORKER = 64;
+
+// The checkpoint of the search of --checkpoint, for the signal handlers.
+static solve_checkpoint *activeCheckpoint = NULL;
+
+// Set when the search of --checkpoint is to save its position and stop.
+static int interrupted = 0;
+
+/*
+    Handles the timer of --every: the search saves its position at its next node.
+
+    \param signalNumber the signal received
+*/
+static void request_checkpoint(int signalNumber) {
+    (void) signalNumber;
+    __atomic_store_n(&activeCheckpoint->requested, 1, __ATOMIC_RELAXED);
+}
+
+/*
+    Handles SIGTERM, SIGINT and SIGXCPU: the search saves its position and stops.
+
+    \param signalNumber the signal received
+*/
+static void interrupt_search(int signalNumber) {
+    request_checkpoint(signalNumber);
+    __atomic_store_n(&interrupted, 1, __ATOMIC_RELAXED);
+}
+
+/*
+    Makes the search save its position when the process is told to stop, and every few seconds.
+
+    \param checkpoint the checkpoint the search saves its position through
+    \param interval the number of seconds between two saves, or 0 to only save when stopped
+*/
+static void start_checkpointing(solve_checkpoint *checkpoint, long interval) {
+    activeCheckpoint = checkpoint;
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    action.sa_handler = interrupt_search;
+    sigaction(SIGTERM, &action, NULL);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGXCPU, &action, NULL); // Sent by ulimit -t, when the soft limit is below the hard one.
+    action.sa_handler = request_checkpoint;
+    sigaction(SIGALRM, &action, NULL);
+
+    if(interval > 0) {
+        struct itimerval timer = {{interval, 0}, {interval, 0}};
+        setitimer(ITIMER_REAL, &timer, NULL);
+    }
+}
+
+/*
+    Stops the timer of start_checkpointing.
+*/
+static void stop_checkpointing(void) {
+    struct itimerval timer = {{0, 0}, {0, 0}};
+    setitimer(ITIMER_REAL, &timer, NULL);
+}
 
-int main() {
-    sudoku * givenSudoku = read_sudoku(stdin);
+/*
+    Checks if two sudokus hold the same cells.
+*/
+static bool same_sudoku(const sudoku *a, const sudoku *b) {
+    return a->size == b->size && memcmp(a->cells, b->cells, sizeof(int) * get_no_cells(a)) == 0;
+}
+
+/*
+    Checks if a saved position can be resumed on a sudoku: saved for the same one, and no deeper
+    than its number of empty cells, which is as deep as its search goes.
+*/
+static bool can_resume(const search_position *position, const sudoku *s) {
+    unsigned noBlanks = 0;
+    for(unsigned i = 0; i < get_no_cells(s); ++i) {
+        noBlanks += s->cells[i] == 0;
+    }
+    return same_sudoku(position->puzzle, s) && position->depth <= noBlanks;
+}
+
+/*
+    Memory reused by every search of a run, so that searching makes no heap allocation once it's
+    large enough for the largest sudoku seen (see solve_sudoku_into).
+*/
+typedef struct {
+    void *scratch; //< from malloc, which aligns to at least ARENA_ALIGNMENT on the platforms we build for
+    size_t scratchSize;
+    sudoku solution; //< the solution of the last search, its cells sized for noCells
+    unsigned noCells;
+} solve_buffers;
+
+/*
+    Solves a sudoku into buffers, growing them first if needed.
+
+    \param buffers the buffers to use
+    \param givenSudoku the sudoku to solve
+
+    \return the result of the search, its solution being the one of the buffers
+*/
+static solve_result solve_into_buffers(solve_buffers *buffers, const sudoku *givenSudoku) {
+    if(solve_scratch_size(givenSudoku->size) > buffers->scratchSize) {
+        free(buffers->scratch);
+        buffers->scratchSize = solve_scratch_size(givenSudoku->size);
+        buffers->scratch = malloc(buffers->scratchSize);
+        assert(buffers->scratch != NULL);
+    }
+    if(get_no_cells(givenSudoku) > buffers->noCells) {
+        free(buffers->solution.cells);
+        buffers->noCells = get_no_cells(givenSudoku);
+        buffers->solution.cells = malloc(sizeof(int) * buffers->noCells);
+        assert(buffers->solution.cells != NULL);
+    }
+    buffers->solution.size = givenSudoku->size;
+
+    solve_result result;
+    result.status = solve_sudoku_into(givenSudoku, &buffers->solution, buffers->scratch, buffers->scratchSize, 0);
+    result.solution = result.status == SR_SOLVED || result.status == SR_MULTIPLE ? &buffers->solution : NULL;
+    return result;
+}
+
+/*
+    Checks and solves a sudoku, then writes the solution (or why there isn't one) to the output.
+
+    \param givenSudoku the sudoku to solve
+    \param cache where to look up and store results, or NULL to always search
+    \param portfolio race all the engines against each other instead of only using solve_sudoku
+    \param options solve with dancing links and these options, or NULL
+    \param buffers solve with solve_sudoku_into and these buffers, or NULL
+    \param output the output stream to write to
+    \param write how to write the solution: write_sudoku or write_sudoku_line
+
+    \return false if the search was cancelled through the options, and nothing was written
+*/
+static bool solve_and_write(const sudoku *givenSudoku, solve_cache *cache, bool portfolio, const solve_options *options,
+                            solve_buffers *buffers, FILE *output, void (*write)(FILE *, const sudoku *)) {
     switch (check_sudoku(givenSudoku)) {
         case CR_INVALID:
-            printf("%s\n", "UNSOLVABLE");
+            fprintf(output, "%s\n", "UNSOLVABLE");
             break;
         case CR_COMPLETE:
-            write_sudoku(stdout, givenSudoku);
+            write(output, givenSudoku);
             break;
         case CR_INCOMPLETE:
             ; // Makes the variable initalization below work
-            solve_result result = solve_sudoku(givenSudoku);
+            solve_result result = cache != NULL ? cached_solve_sudoku(cache, givenSudoku)
+                                : portfolio ? solve_sudoku_portfolio(givenSudoku, NULL, 0)
+                                : options != NULL ? solve_sudoku_dlx(NULL, givenSudoku, options)
+                                : buffers != NULL ? solve_into_buffers(buffers, givenSudoku)
+                                : solve_sudoku(givenSudoku);
+            const bool ownsSolution = result.solution != NULL && buffers == NULL;
 
             switch (result.status) {
                 case SR_UNSOLVABLE:
-                    printf("%s\n", "UNSOLVABLE");
+                    fprintf(output, "%s\n", "UNSOLVABLE");
                     break;
                 case SR_MULTIPLE:
-                    printf("%s\n", "MULTIPLE");
-                    free_sudoku(result.solution);
+                    fprintf(output, "%s\n", "MULTIPLE");
+                    if(ownsSolution) {
+                        free_sudoku(result.solution);
+                    }
                     break;
                 case SR_SOLVED:
-                    write_sudoku(stdout, result.solution);
-                    free_sudoku(result.solution);
+                    write(output, result.solution);
+                    if(ownsSolution) {
+                        free_sudoku(result.solution);
+                    }
+                    break;
+                case SR_ABORTED:
+                    return false;
+                case SR_NO_MEMORY:
+                    // Written in place of the answer, so the answers of --lines stay in step.
+                    fprintf(output, "%s\n", "OUT_OF_MEMORY");
                     break;
             }
             break;
     }
+    return true;
+}
 
-    free_sudoku(givenSudoku);
+/*
+    Counts the solutions of a sudoku and writes their number, or OVERFLOW if it doesn't fit.
+
+    \param givenSudoku the sudoku to count the solutions of
+    \param output the output stream to write to
+*/
+static void count_and_write(const sudoku *givenSudoku, FILE *output) {
+    count_result result = count_solutions(givenSudoku);
+    if(result.overflow) {
+        fprintf(output, "%s\n", "OVERFLOW");
+    }
+    else {
+        write_count(output, result.noSolutions);
+        fprintf(output, "\n");
+    }
+}
+
+/*
+    Solves a sudoku read by the pipeline of --threads and writes its answer as one line.
+
+    \param givenSudoku the sudoku to solve, or NULL for a malformed line
+    \param output where to write the answer
+    \param context points to a bool telling if the engines should be raced
+*/
+static void solve_line(const sudoku *givenSudoku, FILE *output, void *context) {
+    if(givenSudoku == NULL) {
+        fprintf(output, "%s\n", "INVALID");
+        return;
+    }
+    solve_and_write(givenSudoku, NULL, *(const bool *) context, NULL, NULL, output, write_sudoku_line);
+}
+
+/*
+    Usage: sudoku_solver [--lines [--threads N]] [--cache FILE | --portfolio]
+                         [--progress SECONDS [--stats FILE]] [--checkpoint FILE [--every SECONDS]]
+                         [--count]
+
+    Without options, solves the single sudoku given on the standard input.
+
+    --lines         solve every sudoku given one per line (see read_sudoku_line) and write one
+                    answer per line, INVALID for a line that isn't a sudoku
+    --threads N     with --lines, read, solve and write in a pipeline: sudokus are read by one
+                    thread, solved by N, the hardest first (see sudoku_hardness.h), and the
+                    answers written by another, still in input order (see sudoku_pipeline.h)
+    --cache FILE    answer sudokus equivalent to one solved before from a cache of results
+                    (see sudoku_canon.h), loaded from FILE if it exists and saved back to it
+    --portfolio     race all the solving engines on every sudoku, one thread each, and take the
+                    answer of the first to finish (see sudoku_portfolio.h)
+    --progress SECONDS
+                    solve the single sudoku with dancing links and report how far the search got
+                    every SECONDS seconds, or only on SIGUSR1 if 0 (see sudoku_progress.h)
+    --stats FILE    write the progress reports to FILE instead of the standard error
+    --checkpoint FILE
+                    solve the single sudoku with dancing links, resuming the search from the
+                    position saved in FILE if it was saved for the same sudoku; save the position
+                    there and stop on SIGTERM, SIGINT or SIGXCPU (with exit status 2), and remove
+                    the file once the search is over (see sudoku_checkpoint.h)
+    --every SECONDS also save the position every SECONDS seconds, which survives a SIGKILL
+    --count         write the number of solutions of every sudoku instead of solving it, counted
+                    with the help of its symmetries (see sudoku_count.h)
+    --trace FILE    write a timeline of the solver phases of every sudoku to FILE, in the Chrome
+                    trace event format (only if built with make TRACE=1, see sudoku_trace.h)
+*/
+int main(int argc, char **argv) {
+    bool lines = false;
+    const char *cachePath = NULL;
+    bool portfolio = false;
+    long noThreads = 0;
+    long progressInterval = -1;
+    const char *statsPath = NULL;
+    const char *checkpointPath = NULL;
+    long checkpointInterval = 0;
+    bool count = false;
+    bool usageError = false;
+
+    for(int i = 1; i < argc; ++i) {
+        if(strcmp(argv[i], "--lines") == 0) {
+            lines = true;
+        }
+        else if(strcmp(argv[i], "--cache") == 0 && i + 1 < argc) {
+            cachePath = argv[++i];
+        }
+        else if(strcmp(argv[i], "--count") == 0) {
+            count = true;
+        }
+        else if(strcmp(argv[i], "--portfolio") == 0) {
+            portfolio = true;
+        }
+#ifdef SUDOKU_TRACE
+        else if(strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            if(trace_start(argv[++i]) != 0) {
+                perror(argv[i]);
+                return 1;
+            }
+        }
+#endif
+        else if(strcmp(argv[i], "--progress") == 0 && i + 1 < argc) {
+            progressInterval = strtol(argv[++i], NULL, 10);
+            usageError = usageError || progressInterval < 0;
+        }
+        else if(strcmp(argv[i], "--stats") == 0 && i + 1 < argc) {
+            statsPath = argv[++i];
+        }
+        else if(strcmp(argv[i], "--checkpoint") == 0 && i + 1 < argc) {
+            checkpointPath = argv[++i];
+        }
+        else if(strcmp(argv[i], "--every") == 0 && i + 1 < argc) {
+            checkpointInterval = strtol(argv[++i], NULL, 10);
+            usageError = usageError || checkpointInterval < 1;
+        }
+        else if(strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            noThreads = strtol(argv[++i], NULL, 10);
+            usageError = usageError || noThreads < 1;
+        }
+        else {
+            usageError = true;
+        }
+    }
+    // The cache isn't thread safe, so it can't be shared by the workers of a pipeline.
+    // Progress is reported on, and checkpoints taken of, the search of a single sudoku.
+    bool reportProgress = progressInterval >= 0;
+    bool singleSearch = reportProgress || checkpointPath != NULL;
+    if(usageError || (cachePath != NULL && (portfolio || noThreads > 0)) || (noThreads > 0 && !lines)
+       || (singleSearch && (lines || cachePath != NULL || portfolio)) || (statsPath != NULL && !reportProgress)
+       || (checkpointInterval > 0 && checkpointPath == NULL)
+       || (count && (singleSearch || cachePath != NULL || portfolio || noThreads > 0))) {
+        fprintf(stderr, "Usage: %s [--lines [--threads N]] [--cache FILE | --portfolio] "
+                "[--progress SECONDS [--stats FILE]] [--checkpoint FILE [--every SECONDS]] [--count]\n", argv[0]);
+        return 1;
+    }
+
+    FILE *stats = stderr;
+    if(statsPath != NULL && (stats = fopen(statsPath, "w")) == NULL) {
+        perror(statsPath);
+        return 1;
+    }
+
+    solve_cache *cache = NULL;
+    if(cachePath != NULL) {
+        cache = create_solve_cache(CACHE_CAPACITY);
+        load_solve_cache(cache, cachePath); // A missing file just means an empty cache.
+    }
+
+    int status = 0;
+    if(lines && noThreads > 0) {
+        run_pipeline(stdin, stdout, read_sudoku_line_checked, solve_line, &portfolio, estimate_hardness, noThreads,
+                     noThreads * WINDOW_PER_WORKER);
+    }
+    else if(lines) {
+        // Plain searches reuse the same memory for every sudoku.
+        solve_buffers buffers = {NULL, 0, {0, NULL}, 0};
+        sudoku *givenSudoku;
+        read_status status;
+        unsigned long number = 1;
+        TRACE_PUZZLE(number);
+        while((givenSudoku = read_sudoku_line_checked(stdin, &status)) != NULL || status == READ_MALFORMED) {
+            if(givenSudoku == NULL) {
+                // Every line gets its answer, so the answers stay in line with the input.
+                fprintf(stdout, "%s\n", "INVALID");
+                TRACE_PUZZLE(++number);
+                continue;
+            }
+            if(count) {
+                count_and_write(givenSudoku, stdout);
+            }
+            else {
+                solve_and_write(givenSudoku, cache, portfolio, NULL, cache == NULL && !portfolio ? &buffers : NULL,
+                                stdout, write_sudoku_line);
+            }
+            free_sudoku(givenSudoku);
+            TRACE_PUZZLE(++number);
+        }
+        free(buffers.scratch);
+        free(buffers.solution.cells);
+    }
+    else {
+        TRACE_PUZZLE(1);
+        sudoku * givenSudoku = read_sudoku(stdin);
+        if(givenSudoku != NULL && count) {
+            count_and_write(givenSudoku, stdout);
+            free_sudoku(givenSudoku);
+        }
+        else if(givenSudoku != NULL) {
+            solve_options options = {0, false, NULL, NULL, NULL, NULL, NULL, false};
+            solve_progress progress = {0};
+            progress_reporter *reporter = NULL;
+            if(reportProgress) {
+                options.progress = &progress;
+                reporter = start_progress_reporter(&progress, stats, progressInterval);
+            }
+
+            solve_checkpoint checkpoint = {checkpointPath, 0, 0, 0, NULL};
+            search_position *resume = NULL;
+            if(checkpointPath != NULL) {
+                resume = load_search_position(checkpointPath);
+                if(resume != NULL && !can_resume(resume, givenSudoku)) {
+                    fprintf(stderr, "%s: saved for another sudoku, starting over\n", checkpointPath);
+                    free_search_position(resume);
+                    resume = NULL;
+                }
+                checkpoint.resume = resume;
+                options.checkpoint = &checkpoint;
+                options.cancel = &interrupted;
+                start_checkpointing(&checkpoint, checkpointInterval);
+            }
+
+            bool finished = solve_and_write(givenSudoku, cache, portfolio, singleSearch ? &options : NULL, NULL,
+                                            stdout, write_sudoku);
+
+            if(checkpointPath != NULL) {
+                stop_checkpointing();
+                if(resume != NULL) {
+                    free_search_position(resume);
+                }
+                if(checkpoint.status != 0) {
+                    fprintf(stderr, "%s: couldn't save the position of the search\n", checkpointPath);
+                    status = 1;
+                }
+                if(finished) {
+                    remove(checkpointPath);
+                }
+                else if(checkpoint.noSaved > 0) {
+                    fprintf(stderr, "interrupted, position saved to %s\n", checkpointPath);
+                    status = 2;
+                }
+                else {
+                    fprintf(stderr, "interrupted before the position could be saved\n");
+                    status = 2;
+                }
+            }
+            if(reporter != NULL) {
+                stop_progress_reporter(reporter);
+            }
+            free_sudoku(givenSudoku);
+        }
+        else {
+            status = 1;
+        }
+    }
+
+#ifdef SUDOKU_TRACE
+    if(trace_finish() != 0) {
+        perror("trace");
+        status = 1;
+    }
+#endif
+
+    if(stats != stderr) {
+        fclose(stats);
+    }
+
+    if(cache != NULL) {
+        if(save_solve_cache(cache, cachePath) != 0) {
+            perror(cachePath);
+            status = 1;
+        }
+        free_solve_cache(cache);
+    }
 
-    return 0;
+    return status;
 }
@@ -0,0 +1,157 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "sudoku_trace.h"
+
+#ifdef SUDOKU_TRACE
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Number of events in every chunk of a thread buffer.
+#define EVENTS_PER_CHUNK 4096
+
+typedef struct {
+    const char *name;
+    uint64_t timestamp; //< nanoseconds since trace_start
+    unsigned long puzzle; //< the puzzle being worked on, 0 if none
+    bool begin;
+} trace_event_record;
+
+typedef struct trace_chunk {
+    trace_event_record events[EVENTS_PER_CHUNK];
+    unsigned noEvents;
+    struct trace_chunk *next;
+} trace_chunk;
+
+/*
+    The events of one thread. Only its thread appends to it, so no locking is needed; buffers are
+    pushed onto a shared list once, with a compare and swap.
+*/
+typedef struct trace_buffer {
+    unsigned threadNumber;
+    unsigned long puzzle; //< the puzzle the thread is working on
+    trace_chunk *first;
+    trace_chunk *last;
+    struct trace_buffer *next;
+} trace_buffer;
+
+static int traceEnabled = 0;
+static FILE *traceFile = NULL;
+static struct timespec traceStart;
+static trace_buffer *traceBuffers = NULL; //< every thread's buffer, newest first
+static unsigned noTracedThreads = 0;
+static __thread trace_buffer *threadBuffer = NULL;
+
+static uint64_t nanoseconds_since_start(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) (now.tv_sec - traceStart.tv_sec) * 1000000000u + now.tv_nsec - traceStart.tv_nsec;
+}
+
+static trace_chunk *new_chunk(void) {
+    trace_chunk *chunk = malloc(sizeof(trace_chunk));
+    assert(chunk != NULL);
+    chunk->noEvents = 0;
+    chunk->next = NULL;
+    return chunk;
+}
+
+/*
+    Finds the buffer of the calling thread, creating and registering it on first use.
+*/
+static trace_buffer *get_thread_buffer(void) {
+    if(threadBuffer == NULL) {
+        trace_buffer *buffer = malloc(sizeof(trace_buffer));
+        assert(buffer != NULL);
+        buffer->threadNumber = __atomic_add_fetch(&noTracedThreads, 1, __ATOMIC_RELAXED);
+        buffer->puzzle = 0;
+        buffer->first = buffer->last = new_chunk();
+
+        buffer->next = __atomic_load_n(&traceBuffers, __ATOMIC_RELAXED);
+        while(!__atomic_compare_exchange_n(&traceBuffers, &buffer->next, buffer, true,
+                                           __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+            // buffer->next now holds the new head, try again.
+        }
+        threadBuffer = buffer;
+    }
+    return threadBuffer;
+}
+
+int trace_start(const char *path) {
+    traceFile = fopen(path, "w");
+    if(traceFile == NULL) {
+        return -1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &traceStart);
+    __atomic_store_n(&traceEnabled, 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+void trace_event(const char *name, int begin) {
+    if(!__atomic_load_n(&traceEnabled, __ATOMIC_RELAXED)) {
+        return;
+    }
+
+    trace_buffer *buffer = get_thread_buffer();
+    if(buffer->last->noEvents == EVENTS_PER_CHUNK) {
+        buffer->last->next = new_chunk();
+        buffer->last = buffer->last->next;
+    }
+    buffer->last->events[buffer->last->noEvents++] =
+        (trace_event_record){name, nanoseconds_since_start(), buffer->puzzle, begin != 0};
+}
+
+void trace_puzzle(unsigned long number) {
+    if(__atomic_load_n(&traceEnabled, __ATOMIC_RELAXED)) {
+        get_thread_buffer()->puzzle = number;
+    }
+}
+
+int trace_finish(void) {
+    if(traceFile == NULL) {
+        return 0;
+    }
+    __atomic_store_n(&traceEnabled, 0, __ATOMIC_RELAXED);
+
+    fprintf(traceFile, "{\"traceEvents\":[\n");
+    bool first = true;
+    trace_buffer *buffer = __atomic_load_n(&traceBuffers, __ATOMIC_ACQUIRE);
+    while(buffer != NULL) {
+        fprintf(traceFile, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,"
+                "\"args\":{\"name\":\"thread %u\"}}", first ? "" : ",\n", buffer->threadNumber, buffer->threadNumber);
+        first = false;
+
+        trace_chunk *chunk = buffer->first;
+        while(chunk != NULL) {
+            for(unsigned i = 0; i < chunk->noEvents; ++i) {
+                const trace_event_record *event = &chunk->events[i];
+                fprintf(traceFile, ",\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%u",
+                        event->name, event->begin ? 'B' : 'E', event->timestamp / 1e3, buffer->threadNumber);
+                if(event->puzzle != 0) {
+                    fprintf(traceFile, ",\"args\":{\"puzzle\":%lu}", event->puzzle);
+                }
+                fprintf(traceFile, "}");
+            }
+            trace_chunk *next = chunk->next;
+            free(chunk);
+            chunk = next;
+        }
+
+        trace_buffer *next = buffer->next;
+        free(buffer);
+        buffer = next;
+    }
+    fprintf(traceFile, "\n]}\n");
+
+    traceBuffers = NULL;
+    threadBuffer = NULL;
+    int status = fclose(traceFile) == 0 ? 0 : -1;
+    traceFile = NULL;
+    return status;
+}
+
+#endif /* SUDOKU_TRACE */
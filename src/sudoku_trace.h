@@ -0,0 +1,63 @@
+/*
+    \file sudoku_trace.h
+    \brief Opt-in timeline tracing of the solver phases, written in the Chrome trace event format
+
+    Tracing is compiled in by defining SUDOKU_TRACE (make TRACE=1). Without it, all the macros
+    below expand to no-ops, so the traced functions are exactly what they would be otherwise.
+
+    With it, every thread appends the start and end of its spans to a buffer of its own, without
+    locking, once trace_start has been called. trace_finish writes all the buffers as a JSON file
+    that chrome://tracing and Perfetto can open, with a track per thread and the number of the
+    puzzle being worked on attached to every span.
+*/
+
+#ifndef SUDOKU_TRACE_H
+#define SUDOKU_TRACE_H
+
+#ifdef SUDOKU_TRACE
+
+/*
+    Starts recording spans.
+
+    \param path the file trace_finish writes the trace to
+
+    \return 0 on success, -1 if the file can't be written
+*/
+int trace_start(const char *path);
+
+/*
+    Writes everything recorded by every thread to the file given to trace_start and stops
+    recording. No other thread may be recording spans anymore.
+
+    \return 0 on success, -1 on a write error
+*/
+int trace_finish(void);
+
+/*
+    Records the start or the end of a span on the calling thread.
+
+    \param name the name of the span, which must stay valid until trace_finish
+    \param begin true for the start, false for the end
+*/
+void trace_event(const char *name, int begin);
+
+/*
+    Sets the number of the puzzle the calling thread is working on, attached to its next spans.
+
+    \param number the number of the puzzle, counting from 1
+*/
+void trace_puzzle(unsigned long number);
+
+#define TRACE_BEGIN(name) trace_event((name), 1)
+#define TRACE_END(name) trace_event((name), 0)
+#define TRACE_PUZZLE(number) trace_puzzle(number)
+
+#else
+
+#define TRACE_BEGIN(name) ((void) 0)
+#define TRACE_END(name) ((void) 0)
+#define TRACE_PUZZLE(number) ((void) (number))
+
+#endif /* SUDOKU_TRACE */
+
+#endif /* end of include guard: SUDOKU_TRACE_H */
@@ -0,0 +1,3 @@
+#!/bin/bash
+
+ulimit -t 5; ./sudoku_check --stream
\ No newline at end of file
@@ -0,0 +1,3 @@
+#!/bin/bash
+
+ulimit -t 30; ./sudoku_solver --count
\ No newline at end of file